@@ -0,0 +1,73 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Conjuntos de vértices representados como arreglos de palabras de 64 bits.
+// El vértice i corresponde al bit (i % 64) de la palabra (i / 64).
+#define BITSET_WORDS(n) (((n) + 63) / 64)
+
+static inline void bitsetClear(uint64_t *set, int words) {
+  memset(set, 0, words * sizeof(uint64_t));
+}
+
+static inline void bitsetSet(uint64_t *set, int i) {
+  set[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+static inline void bitsetReset(uint64_t *set, int i) {
+  set[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+static inline bool bitsetTest(const uint64_t *set, int i) {
+  return (set[i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void bitsetOr(uint64_t *dst, const uint64_t *src, int words) {
+  for (int w = 0; w < words; w++) {
+    dst[w] |= src[w];
+  }
+}
+
+static inline bool bitsetIntersects(const uint64_t *a, const uint64_t *b,
+                                    int words) {
+  for (int w = 0; w < words; w++) {
+    if (a[w] & b[w]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static inline bool bitsetEqual(const uint64_t *a, const uint64_t *b,
+                               int words) {
+  return memcmp(a, b, words * sizeof(uint64_t)) == 0;
+}
+
+// Índice del primer elemento >= from, o -1 si no hay más
+static inline int bitsetNext(const uint64_t *set, int words, int from) {
+  int w = from >> 6;
+  if (w >= words) {
+    return -1;
+  }
+  uint64_t word = set[w] & (~(uint64_t)0 << (from & 63));
+  while (word == 0) {
+    if (++w == words) {
+      return -1;
+    }
+    word = set[w];
+  }
+  return (w << 6) + __builtin_ctzll(word);
+}
+
+static inline int bitsetCount(const uint64_t *set, int words) {
+  int count = 0;
+  for (int w = 0; w < words; w++) {
+    count += __builtin_popcountll(set[w]);
+  }
+  return count;
+}
+
+#endif
@@ -0,0 +1,289 @@
+#include "codegen.h"
+#include "conflicts.h"
+#include "graph.h"
+#include "phase_plan.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * Función: isIdentifier
+ * Indica si el nombre sirve como identificador de C (letras, dígitos y '_', sin empezar con dígito).
+ */
+static int isIdentifier(const char *name) {
+  if (name[0] == '\0' || isdigit((unsigned char)name[0])) {
+    return 0;
+  }
+  for (const char *c = name; *c != '\0'; c++) {
+    if (!isalnum((unsigned char)*c) && *c != '_') {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Función: writeStringLiteral
+ * Escribe una cadena como literal de C, escapando en octal los caracteres que no son alfanuméricos.
+ */
+static void writeStringLiteral(FILE *file, const char *text) {
+  fputc('"', file);
+  for (const char *c = text; *c != '\0'; c++) {
+    if (isalnum((unsigned char)*c) || *c == '_' || *c == '-') {
+      fputc(*c, file);
+    } else {
+      fprintf(file, "\\%03o", (unsigned char)*c);
+    }
+  }
+  fputc('"', file);
+}
+
+/*
+ * Función: writeHeader
+ * Escribe la cabecera del módulo generado: dimensiones del plan, estado del controlador y funciones.
+ */
+static void writeHeader(FILE *file, const PhasePlan *plan, const char *name,
+                        const char *macro, const char *type) {
+  fprintf(file, "/* Generado por program_output --exportar. No editar. */\n");
+  fprintf(file, "#ifndef %s_H\n#define %s_H\n\n", macro, macro);
+  fprintf(file, "#include <stdint.h>\n\n");
+  fprintf(file, "#define %s_NUM_MOVEMENTS %d\n", macro, plan->numMovements);
+  fprintf(file, "#define %s_NUM_PHASES %d\n", macro, plan->numPhases);
+  fprintf(file, "#define %s_CYCLE %d /* Decimas de segundo */\n", macro,
+          plan->cycle);
+  fprintf(file, "#define %s_TICK_MS 100 /* Periodo de %sTick() */\n\n", macro,
+          name);
+
+  fprintf(file, "/* Estado del controlador: verde de `phase` o, si `clearing` "
+                "es 1, despeje de\n");
+  fprintf(file, "   `phase` hacia `next`. `remaining` son los ticks que "
+                "quedan, incluido el actual. */\n");
+  fprintf(file, "typedef struct %sState {\n", type);
+  fprintf(file, "  uint8_t phase;\n  uint8_t next;\n  uint8_t clearing;\n");
+  fprintf(file, "  uint16_t remaining;\n} %sState;\n\n", type);
+
+  fprintf(file, "void %sInit(%sState *state);\n", name, type);
+  fprintf(file, "void %sTick(%sState *state);\n", name, type);
+  fprintf(file, "void %sRequestPhase(%sState *state, int phase);\n", name,
+          type);
+  fprintf(file, "uint64_t %sGreenMask(const %sState *state);\n", name, type);
+  fprintf(file, "int %sIsGreen(const %sState *state, int movement);\n", name,
+          type);
+  fprintf(file, "const char *%sMovementName(int movement);\n\n", name);
+  fprintf(file, "#endif\n");
+}
+
+/*
+ * Función: writeSource
+ * Escribe las tablas constantes del plan y la máquina de estados que las recorre.
+ */
+static void writeSource(FILE *file, Graph *graph, const PhasePlan *plan,
+                        const char *name, const char *macro, const char *type) {
+  int numPhases = plan->numPhases;
+
+  fprintf(file, "/* Generado por program_output --exportar. No editar. */\n");
+  fprintf(file, "#include \"%s.h\"\n\n", name);
+
+  fprintf(file, "/* Verde de cada fase, en ticks */\n");
+  fprintf(file, "static const uint16_t %sGreen[%s_NUM_PHASES] = {", name,
+          macro);
+  for (int k = 0; k < numPhases; k++) {
+    fprintf(file, "%s%d", k ? ", " : "", plan->green[k]);
+  }
+  fprintf(file, "};\n\n");
+
+  fprintf(file, "/* Despeje de la fase i a la fase j, en ticks */\n");
+  fprintf(file,
+          "static const uint16_t %sIntergreen[%s_NUM_PHASES][%s_NUM_PHASES] = "
+          "{\n",
+          name, macro, macro);
+  for (int a = 0; a < numPhases; a++) {
+    fprintf(file, "    {");
+    for (int b = 0; b < numPhases; b++) {
+      fprintf(file, "%s%d", b ? ", " : "", plan->intergreen[a][b]);
+    }
+    fprintf(file, "}%s\n", a + 1 < numPhases ? "," : "");
+  }
+  fprintf(file, "};\n\n");
+
+  fprintf(file, "/* Cruces con verde en cada fase, un bit por cruce */\n");
+  fprintf(file, "static const uint64_t %sPhaseMask[%s_NUM_PHASES] = {\n", name,
+          macro);
+  for (int k = 0; k < numPhases; k++) {
+    fprintf(file, "    UINT64_C(0x%016" PRIx64 ")%s\n", plan->phaseMask[k],
+            k + 1 < numPhases ? "," : "");
+  }
+  fprintf(file, "};\n\n");
+
+  fprintf(file, "/* Fase que sigue a cada fase en el ciclo */\n");
+  fprintf(file, "static const uint8_t %sNextPhase[%s_NUM_PHASES] = {", name,
+          macro);
+  for (int k = 0; k < numPhases; k++) {
+    fprintf(file, "%s%d", k ? ", " : "", (k + 1) % numPhases);
+  }
+  fprintf(file, "};\n\n");
+
+  fprintf(file, "static const char *const %sNames[%s_NUM_MOVEMENTS] = {\n",
+          name, macro);
+  for (int i = 0; i < plan->numMovements; i++) {
+    fprintf(file, "    ");
+    writeStringLiteral(file, graph->adjacencyList[i]->name);
+    fprintf(file, "%s\n", i + 1 < plan->numMovements ? "," : "");
+  }
+  fprintf(file, "};\n\n");
+
+  fprintf(file, "void %sInit(%sState *state) {\n", name, type);
+  fprintf(file, "  state->phase = 0;\n");
+  fprintf(file, "  state->next = %sNextPhase[0];\n", name);
+  fprintf(file, "  state->clearing = 0;\n");
+  fprintf(file, "  state->remaining = %sGreen[0];\n}\n\n", name);
+
+  fprintf(file, "/* Avanza un tick. Hace a lo sumo dos transiciones (verde -> "
+                "despeje -> verde si el\n");
+  fprintf(file, "   despeje es nulo), por lo que su costo es constante. */\n");
+  fprintf(file, "void %sTick(%sState *state) {\n", name, type);
+  fprintf(file, "  if (state->remaining > 1) {\n");
+  fprintf(file, "    state->remaining--;\n    return;\n  }\n");
+  fprintf(file, "  if (!state->clearing) {\n");
+  fprintf(file, "    state->clearing = 1;\n");
+  fprintf(file,
+          "    state->remaining = %sIntergreen[state->phase][state->next];\n",
+          name);
+  fprintf(file, "    if (state->remaining > 0) {\n      return;\n    }\n  }\n");
+  fprintf(file, "  state->phase = state->next;\n");
+  fprintf(file, "  state->next = %sNextPhase[state->phase];\n", name);
+  fprintf(file, "  state->clearing = 0;\n");
+  fprintf(file, "  state->remaining = %sGreen[state->phase];\n}\n\n", name);
+
+  fprintf(file, "/* Cambia la fase que sigue al verde actual (por ejemplo, "
+                "para dar paso a un vehiculo\n");
+  fprintf(file, "   de emergencia). Un despeje ya iniciado no se modifica. "
+                "*/\n");
+  fprintf(file, "void %sRequestPhase(%sState *state, int phase) {\n", name,
+          type);
+  fprintf(file,
+          "  if (phase >= 0 && phase < %s_NUM_PHASES && !state->clearing) {\n",
+          macro);
+  fprintf(file, "    state->next = (uint8_t)phase;\n  }\n}\n\n");
+
+  fprintf(file, "/* Durante el despeje solo siguen en verde los cruces que "
+                "comparten ambas fases */\n");
+  fprintf(file, "uint64_t %sGreenMask(const %sState *state) {\n", name, type);
+  fprintf(file, "  uint64_t mask = %sPhaseMask[state->phase];\n", name);
+  fprintf(file, "  return state->clearing ? mask & %sPhaseMask[state->next] "
+                ": mask;\n}\n\n",
+          name);
+
+  fprintf(file, "int %sIsGreen(const %sState *state, int movement) {\n", name,
+          type);
+  fprintf(file, "  return movement >= 0 && movement < %s_NUM_MOVEMENTS &&\n",
+          macro);
+  fprintf(file, "         ((%sGreenMask(state) >> movement) & 1u);\n}\n\n",
+          name);
+
+  fprintf(file, "const char *%sMovementName(int movement) {\n", name);
+  fprintf(file, "  return movement >= 0 && movement < %s_NUM_MOVEMENTS\n",
+          macro);
+  fprintf(file, "             ? %sNames[movement]\n             : \"\";\n}\n",
+          name);
+}
+
+/*
+ * Función: closeGenerated
+ * Cierra un archivo generado y avisa si alguna escritura o el cierre fallaron.
+ *
+ * Retorno:
+ * - 0 si todo el contenido llegó al archivo.
+ * - -1 en caso contrario.
+ */
+static int closeGenerated(FILE *file, const char *filename) {
+  int failed = ferror(file);
+  if (fclose(file) != 0 || failed) {
+    printf("Error: No se pudo escribir el archivo %s.\n", filename);
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * Función: exportPhasePlan
+ * Genera un módulo de C autónomo (CODEGEN_DIRECTORY/NOMBRE.h y NOMBRE.c) que ejecuta el plan de fases.
+ *
+ * Descripción:
+ * El módulo contiene el plan como tablas `static const` (verde por fase, matriz de despeje, máscara de cruces por
+ * fase, fase siguiente y nombres de los cruces) y una máquina de estados que las recorre. Cada llamada a
+ * NOMBRETick() avanza una décima de segundo en tiempo constante, sin memoria dinámica, sin cadenas ni más
+ * dependencias que <stdint.h>, de modo que puede compilarse por separado para el controlador de campo. Los
+ * identificadores generados llevan NOMBRE como prefijo. Como el módulo va al controlador de campo, antes de
+ * escribirlo se verifica con la matriz de conflictos que ninguna fase junte cruces incompatibles.
+ *
+ * Parámetros:
+ * - graph: Grafo del cruce, usado para los nombres de los cruces y la verificación de conflictos.
+ * - plan: Plan a exportar.
+ * - name: Nombre del módulo; debe ser un identificador de C válido.
+ *
+ * Retorno:
+ * - 0 si ambos archivos se escribieron correctamente.
+ * - -1 si el nombre no es válido, el plan no tiene fases o junta cruces incompatibles, o no se pudo crear o
+ *   escribir algún archivo.
+ */
+int exportPhasePlan(Graph *graph, const PhasePlan *plan, const char *name) {
+  if (strlen(name) >= CODEGEN_NAME_LENGTH || !isIdentifier(name)) {
+    printf("Error: El nombre del modulo debe ser un identificador de C de "
+           "menos de %d caracteres.\n",
+           CODEGEN_NAME_LENGTH);
+    return -1;
+  }
+  if (plan->numPhases == 0) {
+    printf("Error: El plan no tiene fases.\n");
+    return -1;
+  }
+  int conflicts = countPlanConflicts(graph, plan);
+  if (conflicts < 0) {
+    printf("Error: No se pudo verificar el plan con el grafo del cruce.\n");
+    return -1;
+  }
+  if (conflicts > 0) {
+    printf("Error: El plan no se exporta: tiene %d pares de cruces "
+           "incompatibles en la misma fase.\n",
+           conflicts);
+    return -1;
+  }
+  if (mkdir(CODEGEN_DIRECTORY, 0755) != 0 && errno != EEXIST) {
+    printf("Error: No se pudo crear el directorio %s.\n", CODEGEN_DIRECTORY);
+    return -1;
+  }
+
+  char macro[CODEGEN_NAME_LENGTH];
+  char type[CODEGEN_NAME_LENGTH];
+  for (size_t i = 0; i <= strlen(name); i++) {
+    macro[i] = (char)toupper((unsigned char)name[i]);
+    type[i] = name[i];
+  }
+  type[0] = (char)toupper((unsigned char)type[0]);
+
+  char filename[sizeof(CODEGEN_DIRECTORY) + CODEGEN_NAME_LENGTH + 2];
+  snprintf(filename, sizeof(filename), "%s/%s.h", CODEGEN_DIRECTORY, name);
+  FILE *file = fopen(filename, "w");
+  if (file == NULL) {
+    printf("Error: No se pudo crear el archivo %s.\n", filename);
+    return -1;
+  }
+  writeHeader(file, plan, name, macro, type);
+  if (closeGenerated(file, filename) != 0) {
+    return -1;
+  }
+
+  snprintf(filename, sizeof(filename), "%s/%s.c", CODEGEN_DIRECTORY, name);
+  file = fopen(filename, "w");
+  if (file == NULL) {
+    printf("Error: No se pudo crear el archivo %s.\n", filename);
+    return -1;
+  }
+  writeSource(file, graph, plan, name, macro, type);
+  return closeGenerated(file, filename);
+}
@@ -0,0 +1,15 @@
+#ifndef CODEGEN_H
+#define CODEGEN_H
+
+#include "graph.h"
+#include "phase_plan.h"
+
+// Longitud máxima del nombre del módulo generado (sin extensión)
+#define CODEGEN_NAME_LENGTH 32
+// Directorio donde se escriben los módulos generados
+#define CODEGEN_DIRECTORY "generado"
+
+// Funciones a implementar en codegen.c
+int exportPhasePlan(Graph *graph, const PhasePlan *plan, const char *name);
+
+#endif
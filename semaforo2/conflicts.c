@@ -0,0 +1,167 @@
+#include "conflicts.h"
+#include "bitset.h"
+#include "graph.h"
+#include "phase_plan.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Función: buildConflictMatrix
+ * Construye la matriz de incompatibilidades del grafo como filas de bits.
+ *
+ * Descripción:
+ * Las incompatibilidades del archivo de entrada se escriben en un solo sentido, por lo que la matriz se llena de
+ * forma simétrica recorriendo la lista de adyacencia de cada vértice. Con esta representación, saber si un cruce
+ * puede unirse a una fase es una intersección de bits en lugar de comparar cadenas.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ *
+ * Retorno:
+ * - Puntero a la matriz creada, que debe liberarse con freeConflictMatrix().
+ * - NULL si no se puede asignar memoria.
+ */
+ConflictMatrix *buildConflictMatrix(Graph *graph) {
+  ConflictMatrix *conflicts = (ConflictMatrix *)malloc(sizeof(ConflictMatrix));
+  if (conflicts == NULL) {
+    printf("Error: No se pudo asignar la matriz de conflictos en memoria.\n");
+    return NULL;
+  }
+  int n = graph->numVertices;
+  conflicts->numVertices = n;
+  conflicts->words = BITSET_WORDS(n);
+  conflicts->rows =
+      (uint64_t *)calloc((size_t)n * conflicts->words + 1, sizeof(uint64_t));
+  if (conflicts->rows == NULL) {
+    printf("Error: No se pudo asignar la matriz de conflictos en memoria.\n");
+    free(conflicts);
+    return NULL;
+  }
+
+  for (int i = 0; i < n; i++) {
+    Node *currentNode = graph->adjacencyList[i]->next;
+    while (currentNode != NULL) {
+      int j = getIndex(graph, currentNode->name);
+      if (j != -1 && j != i) {
+        bitsetSet(conflictRow(conflicts, i), j);
+        bitsetSet(conflictRow(conflicts, j), i);
+      }
+      currentNode = currentNode->next;
+    }
+  }
+  return conflicts;
+}
+
+/*
+ * Función: freeConflictMatrix
+ * Libera la memoria de una matriz de incompatibilidades.
+ */
+void freeConflictMatrix(ConflictMatrix *conflicts) {
+  if (conflicts) {
+    free(conflicts->rows);
+    free(conflicts);
+  }
+}
+
+/*
+ * Función: groupToBitset
+ * Convierte los nombres de los cruces de un grupo en un conjunto de bits.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - group: Grupo a convertir.
+ * - set: Conjunto de `words` palabras donde se escribe el resultado.
+ * - words: Número de palabras del conjunto.
+ */
+void groupToBitset(Graph *graph, Group *group, uint64_t *set, int words) {
+  bitsetClear(set, words);
+  for (int i = 0; i < group->numTurns; i++) {
+    int index = getIndex(graph, group->turns[i]);
+    if (index != -1) {
+      bitsetSet(set, index);
+    }
+  }
+}
+
+/*
+ * Función: countGroupConflicts
+ * Cuenta los pares de cruces incompatibles que comparten una fase.
+ *
+ * Descripción:
+ * Sirve para verificar un plan: una lista de grupos válida no tiene pares incompatibles. Cada par se cuenta una
+ * vez por cada fase en que coincide.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - groupList: Lista de grupos (fases).
+ *
+ * Retorno:
+ * - Número de pares incompatibles dentro de las fases.
+ * - -1 si no se puede asignar memoria.
+ */
+int countGroupConflicts(Graph *graph, GroupList *groupList) {
+  ConflictMatrix *conflicts = buildConflictMatrix(graph);
+  if (conflicts == NULL) {
+    return -1;
+  }
+  int words = conflicts->words;
+  uint64_t *set = (uint64_t *)malloc(words * sizeof(uint64_t));
+  uint64_t *shared = (uint64_t *)malloc(words * sizeof(uint64_t));
+  if (set == NULL || shared == NULL) {
+    printf("Error: No se pudo asignar la verificacion en memoria.\n");
+    free(shared);
+    free(set);
+    freeConflictMatrix(conflicts);
+    return -1;
+  }
+  int count = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    groupToBitset(graph, g, set, words);
+    for (int i = bitsetNext(set, words, 0); i != -1;
+         i = bitsetNext(set, words, i + 1)) {
+      uint64_t *row = conflictRow(conflicts, i);
+      for (int w = 0; w < words; w++) {
+        shared[w] = row[w] & set[w];
+      }
+      count += bitsetCount(shared, words);
+    }
+  }
+  free(shared);
+  free(set);
+  freeConflictMatrix(conflicts);
+  return count / 2;
+}
+
+/*
+ * Función: countPlanConflicts
+ * Cuenta los pares de cruces incompatibles que comparten una fase de un plan compacto.
+ *
+ * Descripción:
+ * Es la misma verificación que countGroupConflicts() sobre las máscaras de PhasePlan, para revisar un plan que no
+ * viene de una lista de grupos (por ejemplo antes de exportarlo).
+ *
+ * Retorno:
+ * - Número de pares incompatibles dentro de las fases.
+ * - -1 si el plan no corresponde al grafo o no se puede asignar memoria.
+ */
+int countPlanConflicts(Graph *graph, const PhasePlan *plan) {
+  if (plan->numMovements != graph->numVertices) {
+    return -1;
+  }
+  ConflictMatrix *conflicts = buildConflictMatrix(graph);
+  if (conflicts == NULL) {
+    return -1;
+  }
+  int count = 0;
+  for (int k = 0; k < plan->numPhases; k++) {
+    uint64_t mask = plan->phaseMask[k];
+    for (int i = bitsetNext(&mask, 1, 0); i != -1;
+         i = bitsetNext(&mask, 1, i + 1)) {
+      uint64_t shared = conflictRow(conflicts, i)[0] & mask;
+      count += bitsetCount(&shared, 1);
+    }
+  }
+  freeConflictMatrix(conflicts);
+  return count / 2;
+}
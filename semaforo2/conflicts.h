@@ -0,0 +1,28 @@
+#ifndef CONFLICTS_H
+#define CONFLICTS_H
+
+#include "bitset.h"
+#include "graph.h"
+#include "phase_plan.h"
+#include "traffic_lights.h"
+
+// Matriz de incompatibilidades: la fila i es el conjunto de cruces que no
+// pueden tener verde al mismo tiempo que el cruce i
+typedef struct ConflictMatrix {
+  int numVertices;
+  int words; // Palabras de 64 bits por fila
+  uint64_t *rows;
+} ConflictMatrix;
+
+static inline uint64_t *conflictRow(ConflictMatrix *conflicts, int i) {
+  return conflicts->rows + (size_t)i * conflicts->words;
+}
+
+// Funciones a implementar en conflicts.c
+ConflictMatrix *buildConflictMatrix(Graph *graph);
+void freeConflictMatrix(ConflictMatrix *conflicts);
+void groupToBitset(Graph *graph, Group *group, uint64_t *set, int words);
+int countGroupConflicts(Graph *graph, GroupList *groupList);
+int countPlanConflicts(Graph *graph, const PhasePlan *plan);
+
+#endif
@@ -0,0 +1,198 @@
+#include "controller.h"
+#include "bitset.h"
+#include "phase_plan.h"
+#include "trace.h"
+
+#include <string.h>
+
+/*
+ * Función: controllerInit
+ * Prepara el controlador de una intersección para ejecutar un plan.
+ *
+ * Parámetros:
+ * - controller: Controlador a inicializar.
+ * - id: Identificador de la intersección (se usa en los eventos de traza).
+ * - plan: Plan a ejecutar; debe seguir existiendo mientras se use el controlador.
+ * - flows: Demanda de cada cruce en veh/h para las colas, o NULL si solo llegan vehículos con controllerArrival().
+ * - start: Tick en que comienza el verde de la primera fase.
+ *
+ * Retorno: Ninguno.
+ */
+void controllerInit(Controller *controller, int id, const PhasePlan *plan,
+                    const double *flows, uint64_t start) {
+  memset(controller, 0, sizeof(Controller));
+  controller->id = id;
+  controller->plan = plan;
+  controller->next = plan->numPhases > 1 ? 1 : 0;
+  controller->lastUpdate = start;
+  controller->changeTime =
+      plan->numPhases > 0 ? start + plan->green[0] : UINT64_MAX;
+  for (int i = 0; i < plan->numMovements && flows != NULL; i++) {
+    controller->arrivalRate[i] = (float)(flows[i] / TICKS_PER_HOUR);
+  }
+}
+
+/*
+ * Función: controllerGreenMask
+ * Devuelve los cruces con verde; durante el despeje solo los que comparten ambas fases.
+ */
+uint64_t controllerGreenMask(const Controller *controller) {
+  const PhasePlan *plan = controller->plan;
+  if (controller->clearing && controller->switching) {
+    return controller->switchMask;
+  }
+  if (plan->numPhases == 0) {
+    return 0;
+  }
+  uint64_t mask = plan->phaseMask[controller->phase];
+  return controller->clearing ? mask & plan->phaseMask[controller->next]
+                              : mask;
+}
+
+/*
+ * Función: controllerSettle
+ * Actualiza las colas y la demora acumulada hasta el tick `now`.
+ *
+ * Descripción:
+ * Entre dos cambios de estado los verdes no cambian, así que cada cola evoluciona de forma lineal: crece con la
+ * demanda y, si tiene verde, baja al flujo de saturación hasta vaciarse. La demora es el área bajo la curva de la
+ * cola, que se calcula exactamente por trapecios. El costo es proporcional al número de cruces y no al tiempo
+ * transcurrido.
+ *
+ * Parámetros:
+ * - controller: Controlador.
+ * - now: Tick actual; si no es posterior a la última actualización no se hace nada.
+ *
+ * Retorno: Ninguno.
+ */
+void controllerSettle(Controller *controller, uint64_t now) {
+  if (now <= controller->lastUpdate) {
+    return;
+  }
+  double elapsed = (double)(now - controller->lastUpdate);
+  double capacity = SATURATION_FLOW / TICKS_PER_HOUR;
+  uint64_t green = controllerGreenMask(controller);
+
+  for (int i = 0; i < controller->plan->numMovements; i++) {
+    double queue = controller->queue[i];
+    double rate = controller->arrivalRate[i];
+    double drain = capacity - rate; // Velocidad a la que baja la cola
+    controller->arrivals += rate * elapsed;
+
+    if (!bitsetTest(&green, i)) {
+      double after = queue + rate * elapsed;
+      controller->delay += (queue + after) / 2 * elapsed;
+      queue = after;
+    } else if (drain > 0 && queue < drain * elapsed) {
+      // La cola se vacía antes del final y luego se atiende a la llegada
+      controller->delay += queue * (queue / drain) / 2;
+      controller->departures += queue + rate * elapsed;
+      queue = 0;
+    } else {
+      double after = queue - drain * elapsed;
+      controller->delay += (queue + after) / 2 * elapsed;
+      controller->departures += capacity * elapsed;
+      queue = after;
+    }
+    controller->queue[i] = (float)queue;
+  }
+  controller->lastUpdate = now;
+}
+
+/*
+ * Función: controllerArrival
+ * Registra la llegada de un vehículo detectado en un cruce y emite su evento de detector en la traza.
+ */
+void controllerArrival(Controller *controller, int movement, uint64_t now) {
+  if (movement < 0 || movement >= controller->plan->numMovements) {
+    return;
+  }
+  traceEvent(TRACE_DETECTOR, (uint16_t)movement, (uint32_t)controller->id);
+  controllerSettle(controller, now);
+  controller->queue[movement] += 1;
+  controller->arrivals += 1;
+}
+
+/*
+ * Función: controllerAdvance
+ * Aplica el cambio de estado que vence en `now` y devuelve el tick del siguiente.
+ *
+ * Descripción:
+ * Al terminar un verde comienza el despeje hacia la fase siguiente; al terminar el despeje (o de inmediato si el
+ * despeje es nulo) comienza el verde de esa fase. Registra TRACE_PHASE_END y TRACE_PHASE_START con la fase y la
+ * intersección. El costo no depende del plan más que por la actualización de las colas.
+ *
+ * Parámetros:
+ * - controller: Controlador cuyo cambio vence.
+ * - now: Tick actual.
+ *
+ * Retorno:
+ * - Tick del siguiente cambio de estado (UINT64_MAX si el plan no tiene fases).
+ */
+uint64_t controllerAdvance(Controller *controller, uint64_t now) {
+  const PhasePlan *plan = controller->plan;
+  if (plan->numPhases == 0) {
+    return controller->changeTime = UINT64_MAX;
+  }
+  controllerSettle(controller, now);
+
+  if (!controller->clearing) {
+    traceEvent(TRACE_PHASE_END, controller->phase, (uint32_t)controller->id);
+    controller->clearing = 1;
+    uint16_t clearance = plan->intergreen[controller->phase][controller->next];
+    if (clearance > 0) {
+      return controller->changeTime = now + clearance;
+    }
+  }
+
+  controller->phase = controller->next;
+  controller->next = (uint8_t)((controller->phase + 1) % plan->numPhases);
+  controller->clearing = 0;
+  controller->switching = 0;
+  traceEvent(TRACE_PHASE_START, controller->phase, (uint32_t)controller->id);
+  return controller->changeTime = now + plan->green[controller->phase];
+}
+
+/*
+ * Función: controllerSetPlan
+ * Cambia el plan del controlador al terminar el verde de la última fase del plan anterior.
+ *
+ * Descripción:
+ * Debe llamarse en lugar de controllerAdvance() cuando vence el verde de la última fase, para que el cambio ocurra
+ * al final de un ciclo completo. En vez del despeje hacia la fase 0 del plan anterior se aplica `clearance`, el
+ * despeje de la última fase anterior a la fase 0 del plan nuevo (getSwitchIntergreen()); durante él solo siguen en
+ * verde los cruces que están en ambas fases. Las colas se conservan, así que ambos planes deben ser del mismo grafo.
+ *
+ * Parámetros:
+ * - controller: Controlador al final del verde de la última fase.
+ * - plan: Plan nuevo; debe seguir existiendo mientras se use el controlador.
+ * - clearance: Despeje en ticks de la última fase anterior a la fase 0 del plan nuevo.
+ * - now: Tick actual.
+ *
+ * Retorno:
+ * - Tick del siguiente cambio de estado con el plan nuevo (UINT64_MAX si no tiene fases).
+ */
+uint64_t controllerSetPlan(Controller *controller, const PhasePlan *plan,
+                           uint16_t clearance, uint64_t now) {
+  controllerSettle(controller, now);
+  uint64_t previous = controllerGreenMask(controller);
+  traceEvent(TRACE_PHASE_END, controller->phase, (uint32_t)controller->id);
+  controller->plan = plan;
+  if (plan->numPhases == 0) {
+    return controller->changeTime = UINT64_MAX;
+  }
+  controller->next = 0;
+  if (clearance > 0) {
+    controller->clearing = 1;
+    controller->switching = 1;
+    controller->switchMask = previous & plan->phaseMask[0];
+    return controller->changeTime = now + clearance;
+  }
+
+  controller->phase = 0;
+  controller->next = plan->numPhases > 1 ? 1 : 0;
+  controller->clearing = 0;
+  controller->switching = 0;
+  traceEvent(TRACE_PHASE_START, 0, (uint32_t)controller->id);
+  return controller->changeTime = now + plan->green[0];
+}
@@ -0,0 +1,54 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include "phase_plan.h"
+#include <stdint.h>
+
+// Tiempo del controlador en ticks de 100 ms, la misma unidad de PhasePlan
+#define CONTROLLER_TICK_MS 100
+#define TICKS_PER_HOUR 36000.0
+
+// Temporizador intrusivo: va dentro de la estructura que lo usa, así que
+// programarlo no asigna memoria
+typedef struct TimerNode {
+  struct TimerNode *next;
+  struct TimerNode *prev;
+  uint64_t expires; // Tick en que vence
+} TimerNode;
+
+// Máquina de estados de una intersección: verde de `phase` o, si `clearing`
+// es 1, despeje de `phase` hacia `next`. Las colas son un modelo de fluidos:
+// crecen con la demanda y, con verde, se descargan al flujo de saturación.
+typedef struct Controller {
+  TimerNode timer; // Primer miembro: el temporizador apunta al controlador
+  int id;
+  const PhasePlan *plan;
+  uint8_t phase;
+  uint8_t next;
+  uint8_t clearing;
+  uint8_t switching;   // El despeje en curso es un cambio de plan
+  uint64_t switchMask; // Cruces que siguen en verde durante ese despeje
+  uint64_t changeTime; // Tick del siguiente cambio de estado
+  uint64_t lastUpdate; // Tick hasta el que están calculadas las colas
+  float arrivalRate[PLAN_MAX_MOVEMENTS]; // Vehículos por tick
+  float queue[PLAN_MAX_MOVEMENTS];       // Vehículos en espera
+  double delay;      // Vehículos x tick de espera acumulados
+  double arrivals;   // Vehículos llegados
+  double departures; // Vehículos atendidos
+} Controller;
+
+static inline Controller *timerController(TimerNode *timer) {
+  return (Controller *)timer;
+}
+
+// Funciones a implementar en controller.c
+void controllerInit(Controller *controller, int id, const PhasePlan *plan,
+                    const double *flows, uint64_t start);
+uint64_t controllerGreenMask(const Controller *controller);
+void controllerSettle(Controller *controller, uint64_t now);
+void controllerArrival(Controller *controller, int movement, uint64_t now);
+uint64_t controllerAdvance(Controller *controller, uint64_t now);
+uint64_t controllerSetPlan(Controller *controller, const PhasePlan *plan,
+                           uint16_t clearance, uint64_t now);
+
+#endif
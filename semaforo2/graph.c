@@ -16,6 +16,7 @@
  *
  * Retorna:
  * - Puntero al nodo recién creado.
+ * - NULL si no se pudo asignar memoria.
  *
  * Precondiciones:
  * - El nombre del nodo (name) debe ser una cadena de caracteres válida.
@@ -27,6 +28,10 @@
 
 Node *createNode(char *name) {
   Node *newNode = (Node *)malloc(sizeof(Node));
+  if (newNode == NULL) {
+    printf("Error: No se pudo asignar el nodo %s en memoria.\n", name);
+    return NULL;
+  }
   strcpy(newNode->name, name);
   newNode->next = NULL;
   return newNode;
@@ -45,6 +50,7 @@ Node *createNode(char *name) {
  *
  * Retorna:
  * - Puntero al grafo recién creado.
+ * - NULL si no se pudo asignar memoria; lo asignado hasta ese punto se libera.
  *
  * Precondiciones:
  * - El número de vértices (numVertices) debe ser un valor no negativo.
@@ -56,20 +62,35 @@ Node *createNode(char *name) {
  */
 
 Graph *createGraph(int numVertices) {
+  if (numVertices < 0) {
+    printf("Error: El grafo no puede tener %d vertices.\n", numVertices);
+    return NULL;
+  }
   Graph *graph = (Graph *)malloc(sizeof(Graph));
+  if (graph == NULL) {
+    printf("Error: No se pudo asignar el grafo en memoria.\n");
+    return NULL;
+  }
   graph->numVertices = numVertices;
 
-  // Asignar memoria para la adjacency list
-  graph->adjacencyList = (Node **)malloc(numVertices * sizeof(Node *));
+  graph->clearance = NULL;
+  graph->flow = NULL;
 
-  // Inicializar cada adjacency list como vacía
-  for (int i = 0; i < numVertices; i++) {
-    graph->adjacencyList[i] = NULL;
+  // Asignar memoria para la adjacency list, inicializando cada una como vacía
+  graph->adjacencyList = (Node **)calloc(numVertices + 1, sizeof(Node *));
+  if (graph->adjacencyList == NULL) {
+    printf("Error: No se pudo asignar el grafo en memoria.\n");
+    free(graph);
+    return NULL;
   }
-  // Asignar memoria para cada Node en la adjacency list
+  // Asignar memoria para cada Node en la adjacency list, con nombre vacío
   for (int i = 0; i < numVertices; i++) {
-    graph->adjacencyList[i] = (Node *)malloc(sizeof(Node));
-    graph->adjacencyList[i]->next = NULL;
+    graph->adjacencyList[i] = (Node *)calloc(1, sizeof(Node));
+    if (graph->adjacencyList[i] == NULL) {
+      printf("Error: No se pudo asignar el grafo en memoria.\n");
+      freeGraph(graph);
+      return NULL;
+    }
   }
 
   return graph;
@@ -95,6 +116,10 @@ Graph *createGraph(int numVertices) {
  * - Los nombres de origen (source) y destino (destination) deben ser cadenas de
  * caracteres válidas.
  *
+ * Retorno:
+ * - 0 si el arco se añadió o no había que añadirlo.
+ * - -1 si no se pudo asignar memoria para el arco.
+ *
  * Postcondiciones:
  * - Se añade un nuevo arco (edge) desde el nodo fuente (source) hasta el nodo
  * destino (destination) en el grafo especificado.
@@ -103,7 +128,7 @@ Graph *createGraph(int numVertices) {
  * se añade el arco.
  */
 
-void addEdge(Graph *graph, char *source, char *destination) {
+int addEdge(Graph *graph, char *source, char *destination) {
   // Encuentra los nodos correspondientes a `source` y a `destination`
   Node *sourceNode = NULL;
   Node *destinationNode = NULL;
@@ -124,18 +149,22 @@ void addEdge(Graph *graph, char *source, char *destination) {
   // Si cualquiera de los Nodes `source` y `destination` no se encuentra
   // retorna sin añadir un `edge`
   if (sourceNode == NULL || destinationNode == NULL) {
-    return;
+    return 0;
   }
 
   // Checa si el edge ya existe
   if (isEdge(graph, sourceNode->name, destinationNode->name)) {
-    return;
+    return 0;
   }
 
   // Crea un nuevo `edge` desde el Node `source` hacía el Node `destination`
   Node *newEdge = createNode(destination);
+  if (newEdge == NULL) {
+    return -1;
+  }
   newEdge->next = sourceNode->next;
   sourceNode->next = newEdge;
+  return 0;
 }
 
 /*
@@ -174,16 +203,17 @@ void printGraph(Graph *graph) {
  * Libera la memoria asignada al grafo y sus nodos.
  *
  * Descripción:
- * Esta función libera la memoria asignada al grafo y a todos sus nodos, liberando cada nodo de la lista de adyacencia.
+ * Esta función libera la memoria asignada al grafo y a todos sus nodos, liberando cada nodo de la lista de adyacencia,
+ * la lista misma, la matriz de despeje, las demandas y la estructura del grafo.
  *
  * Parámetros:
- * - graph: Puntero al grafo que se liberará de memoria.
+ * - graph: Puntero al grafo que se liberará de memoria (puede ser NULL).
  *
  * Precondiciones:
- * - El grafo (graph) debe ser un puntero válido a una estructura de grafo.
+ * - El grafo (graph) debe ser NULL o un puntero devuelto por createGraph() o readGraphFromFile().
  *
  * Postcondiciones:
- * - Se libera la memoria asignada al grafo y sus nodos, dejándolos en un estado inválido.
+ * - Se libera toda la memoria del grafo; el puntero ya no debe usarse.
  */
 
 void freeGraph(Graph *graph) {
@@ -196,7 +226,106 @@ void freeGraph(Graph *graph) {
         free(temp);
       }
     }
+    free(graph->adjacencyList);
+    free(graph->clearance);
+    free(graph->flow);
+    free(graph);
+  }
+}
+
+/*
+ * Función: parseSectionHeader
+ * Identifica la sección opcional indicada por una línea `[seccion]`.
+ *
+ * Parámetros:
+ * - line: Línea leída del archivo, comenzando con '['.
+ *
+ * Retorno:
+ * - La sección correspondiente, o SECTION_UNKNOWN si no se reconoce (sus líneas se ignoran).
+ */
+
+static GraphSection parseSectionHeader(char *line) {
+  if (strncmp(line, "[despeje]", 9) == 0) {
+    return SECTION_CLEARANCE;
+  }
+  if (strncmp(line, "[flujos]", 8) == 0) {
+    return SECTION_FLOWS;
+  }
+  return SECTION_UNKNOWN;
+}
+
+/*
+ * Función: setClearance
+ * Registra el tiempo de despeje entre dos cruces del grafo.
+ *
+ * Descripción:
+ * La matriz de despeje se crea la primera vez que se necesita, con todas sus entradas en -1 para indicar que
+ * no fueron especificadas (ver getClearance en sequencing.c para el valor por defecto).
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - from: Nombre del cruce que termina su verde.
+ * - to: Nombre del cruce que inicia su verde.
+ * - seconds: Tiempo de despeje en segundos.
+ *
+ * Retorno:
+ * - 0 si se registró o alguno de los nombres no existe en el grafo (en ese caso no se realiza ninguna acción).
+ * - -1 si no se pudo asignar la matriz de despeje.
+ */
+
+int setClearance(Graph *graph, char *from, char *to, double seconds) {
+  int fromIndex = getIndex(graph, from);
+  int toIndex = getIndex(graph, to);
+  if (fromIndex == -1 || toIndex == -1) {
+    return 0;
+  }
+
+  int n = graph->numVertices;
+  if (graph->clearance == NULL) {
+    graph->clearance = (double *)malloc((size_t)n * n * sizeof(double));
+    if (graph->clearance == NULL) {
+      printf("Error: No se pudo asignar la matriz de despeje en memoria.\n");
+      return -1;
+    }
+    for (int i = 0; i < n * n; i++) {
+      graph->clearance[i] = -1;
+    }
   }
+  graph->clearance[fromIndex * n + toIndex] = seconds;
+  return 0;
+}
+
+/*
+ * Función: setFlow
+ * Registra la demanda de un cruce del grafo.
+ *
+ * Descripción:
+ * El arreglo de demandas se crea la primera vez que se necesita, con todos los cruces en 0.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - name: Nombre del cruce.
+ * - vehiclesPerHour: Demanda del cruce en veh/h.
+ *
+ * Retorno:
+ * - 0 si se registró o el nombre no existe en el grafo (en ese caso no se realiza ninguna acción).
+ * - -1 si no se pudo asignar el arreglo de demandas.
+ */
+
+int setFlow(Graph *graph, char *name, double vehiclesPerHour) {
+  int index = getIndex(graph, name);
+  if (index == -1) {
+    return 0;
+  }
+  if (graph->flow == NULL) {
+    graph->flow = (double *)calloc(graph->numVertices, sizeof(double));
+    if (graph->flow == NULL) {
+      printf("Error: No se pudo asignar las demandas en memoria.\n");
+      return -1;
+    }
+  }
+  graph->flow[index] = vehiclesPerHour;
+  return 0;
 }
 
 /*
@@ -206,6 +335,10 @@ void freeGraph(Graph *graph) {
  * Descripción:
  * Esta función lee un grafo desde un archivo de texto, donde se especifica el número de vértices, los nombres de los vértices
  * y los bordes incompatibles. Luego, construye el grafo en memoria utilizando las funciones auxiliares.
+ * Después de los bordes puede aparecer la sección opcional `[despeje]`, con líneas `ORIGEN - DESTINO segundos` que
+ * indican el tiempo de despeje (ámbar más todo rojo) entre el fin del cruce ORIGEN y el inicio del cruce DESTINO.
+ * La sección opcional `[flujos]` tiene líneas `CRUCE veh/h` con la demanda de cada cruce, que activa la
+ * agrupación ponderada por demanda (ver weighted_grouping.c).
  *
  * Parámetros:
  * - filename: Nombre del archivo de texto que contiene la descripción del grafo.
@@ -224,10 +357,14 @@ Graph *readGraphFromFile(char *filename) {
     printf("Error: No se pudo abrir el archivo.\n");
     return NULL;
   }
-  int numVertices;
+  int numVertices = -1;
   fscanf(file, "%d\n", &numVertices);
 
   Graph *graph = createGraph(numVertices);
+  if (graph == NULL) {
+    fclose(file);
+    return NULL;
+  }
 
   char line[100];
   char *token;
@@ -236,25 +373,54 @@ Graph *readGraphFromFile(char *filename) {
   fgets(line, sizeof(line), file);
   token = strtok(line, " \n");
   int vertexIndex = 0;
-  while (token != NULL) {
+  while (token != NULL && vertexIndex < numVertices) {
     strcpy(graph->adjacencyList[vertexIndex]->name, token);
     token = strtok(NULL, " \n");
     vertexIndex++;
   }
 
-  // Leer los `edges` incompatibles
-  while (fgets(line, sizeof(line), file)) {
+  // Leer los `edges` incompatibles y, si existen, las secciones opcionales
+  // que comienzan con una línea `[seccion]`
+  GraphSection section = SECTION_EDGES;
+  int status = 0;
+  while (status == 0 && fgets(line, sizeof(line), file)) {
+    if (line[0] == '[') {
+      section = parseSectionHeader(line);
+      continue;
+    }
     token = strtok(line, " -\n");
     char *source = token;
     token = strtok(NULL, " -\n");
     char *destination = token;
+    if (source == NULL || destination == NULL) {
+      continue; // Línea vacía o incompleta
+    }
 
-    if (strcmp(source, destination) != 0) {
-      addEdge(graph, source, destination);
+    switch (section) {
+    case SECTION_EDGES:
+      if (strcmp(source, destination) != 0) {
+        status = addEdge(graph, source, destination);
+      }
+      break;
+    case SECTION_CLEARANCE:
+      token = strtok(NULL, " \n");
+      if (token != NULL) {
+        status = setClearance(graph, source, destination, atof(token));
+      }
+      break;
+    case SECTION_FLOWS:
+      status = setFlow(graph, source, atof(destination));
+      break;
+    case SECTION_UNKNOWN:
+      break;
     }
   }
 
   fclose(file);
+  if (status != 0) {
+    freeGraph(graph);
+    return NULL;
+  }
   return graph;
 }
 
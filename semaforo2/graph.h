@@ -10,15 +10,27 @@ typedef struct Node {
 typedef struct Graph {
   int numVertices;
   Node **adjacencyList;
+  double *clearance; // Matriz de despeje (s) entre cruces, NULL si no se leyó
+  double *flow;      // Demanda (veh/h) de cada cruce, NULL si no se leyó
 } Graph;
 
+// Secciones del archivo de entrada después de los `edges` incompatibles
+typedef enum GraphSection {
+  SECTION_EDGES,
+  SECTION_CLEARANCE, // [despeje]
+  SECTION_FLOWS,     // [flujos]
+  SECTION_UNKNOWN
+} GraphSection;
+
 // Funciones a implementar en graph.c
 Node *createNode(char *name);
 Graph *createGraph(int numVertices);
 Graph *readGraphFromFile(char *filename);
-void addEdge(Graph *graph, char *source, char *destination);
+int addEdge(Graph *graph, char *source, char *destination);
 void printGraph(Graph *graph);
 void freeGraph(Graph *graph);
 int getIndex(Graph *graph, char *label);
 int isEdge(Graph *graph, char *label1, char *label2);
+int setClearance(Graph *graph, char *from, char *to, double seconds);
+int setFlow(Graph *graph, char *name, double vehiclesPerHour);
 #endif
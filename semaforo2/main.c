@@ -1,10 +1,780 @@
+#include "codegen.h"
+#include "conflicts.h"
 #include "graph.h"
+#include "monte_carlo.h"
+#include "phase_plan.h"
+#include "plan_library.h"
+#include "plan_store.h"
+#include "runtime.h"
+#include "preemption.h"
+#include "recording.h"
+#include "replay.h"
+#include "trace.h"
 #include "traffic_lights.h"
 #include "user_interface.h"
+#include "weighted_grouping.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Función: printUsage
+ * Muestra los modos de ejecución disponibles por línea de comandos.
+ */
+static void printUsage(char *program) {
+  printf("Uso: %s [--traza ARCHIVO] [MODO]\n", program);
+  printf("  (sin modo)\n");
+  printf("      Menu interactivo\n");
+  printf("  --planes GRAFO PERFILES [GRAFO PERFILES ...]\n");
+  printf("      Precalcula en paralelo un plan por perfil de demanda\n");
+  printf("  --preferencia GRAFO CRUCE\n");
+  printf("      Camino mas rapido al verde de CRUCE desde cada fase\n");
+  printf("  --barrido GRAFO PERFILES [ESCENARIOS]\n");
+  printf("      Robustez del plan de cada perfil ante demanda aleatoria\n");
+  printf("  --exportar GRAFO NOMBRE [PERFILES PERFIL]\n");
+  printf("      Genera " CODEGEN_DIRECTORY "/NOMBRE.h y NOMBRE.c con el plan "
+         "para el controlador\n");
+  printf("  --publicar GRAFO PERFILES [GRAFO PERFILES ...]\n");
+  printf("      Publica el plan vigente de cada interseccion en memoria "
+         "compartida\n");
+  printf("  --leer INTERSECCION [INTERSECCION ...]\n");
+  printf("      Lee planes publicados en memoria compartida\n");
+  printf("  --ponderar GRAFO [PERFILES PERFIL]\n");
+  printf("      Compara la agrupacion ponderada por demanda con la original\n");
+  printf("  --controladores GRAFO PERFILES INTERSECCIONES [SEGUNDOS [HILOS "
+         "[simulado]]]\n");
+  printf("      Ejecuta muchas intersecciones sobre un grupo fijo de hilos\n");
+  printf("  --grabar GRAFO PERFILES ARCHIVO [HORAS [SEMILLA]]\n");
+  printf("      Genera una grabacion de detecciones con la demanda del "
+         "horario\n");
+  printf("  --reproducir GRAFO PERFILES ARCHIVO [PERFIL ...]\n");
+  printf("      Reproduce una grabacion con varios planes y compara los "
+         "resultados\n");
+}
+
+/*
+ * Función: loadIntersections
+ * Lee los pares (archivo de grafo, archivo de perfiles) de varias intersecciones.
+ *
+ * Retorno:
+ * - 0 si todas las intersecciones se leyeron. Lo leído debe liberarse con freeIntersections() en cualquier caso.
+ * - 1 si algún archivo no se pudo leer.
+ */
+static int loadIntersections(int numIntersections, char *argv[],
+                             Graph ***graphs, DemandProfileSet **profileSets) {
+  *graphs = (Graph **)calloc(numIntersections, sizeof(Graph *));
+  *profileSets = (DemandProfileSet *)calloc(numIntersections,
+                                            sizeof(DemandProfileSet));
+  for (int i = 0; i < numIntersections; i++) {
+    (*graphs)[i] = readGraphFromFile(argv[2 * i]);
+    if ((*graphs)[i] == NULL ||
+        readDemandProfiles(argv[2 * i + 1], (*graphs)[i], &(*profileSets)[i]) !=
+            0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Función: freeIntersections
+ * Libera los grafos y perfiles leídos con loadIntersections().
+ */
+static void freeIntersections(int numIntersections, Graph **graphs,
+                              DemandProfileSet *profileSets) {
+  for (int i = 0; i < numIntersections; i++) {
+    freeDemandProfiles(&profileSets[i]);
+    freeGraph(graphs[i]);
+  }
+  free(profileSets);
+  free(graphs);
+}
+
+/*
+ * Función: runPlanLibrary
+ * Modo `--planes`: construye la biblioteca de planes por horario de varias intersecciones.
+ *
+ * Descripción:
+ * Recibe pares (archivo de grafo, archivo de perfiles), uno por intersección, construye la biblioteca con un hilo
+ * por núcleo, la imprime y muestra el plan que rige en este momento en cada intersección.
+ */
+static int runPlanLibrary(int argc, char *argv[]) {
+  if (argc < 2 || argc % 2 != 0) {
+    return -1;
+  }
+  int numIntersections = argc / 2;
+  Graph **graphs;
+  DemandProfileSet *profileSets;
+  int status = loadIntersections(numIntersections, argv, &graphs, &profileSets);
+
+  if (status == 0) {
+    int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    PlanLibrary *library =
+        buildPlanLibrary(graphs, profileSets, numIntersections, numThreads);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (library == NULL) {
+      freeIntersections(numIntersections, graphs, profileSets);
+      return 1;
+    }
+
+    printPlanLibrary(library, graphs, profileSets);
+    printf("Biblioteca construida en %.2f ms con %d hilos.\n",
+           (end.tv_sec - start.tv_sec) * 1e3 +
+               (end.tv_nsec - start.tv_nsec) / 1e6,
+           numThreads);
+
+    time_t now = time(NULL);
+    struct tm *local = localtime(&now);
+    int minute = local->tm_hour * 60 + local->tm_min;
+    for (int i = 0; i < numIntersections; i++) {
+      int profile = library->schedule[i * MINUTES_PER_DAY + minute];
+      if (library->status[i * MAX_PROFILES + profile] != 0) {
+        printf("Interseccion %d a las %02d:%02d: perfil %s sin plan valido\n",
+               i, local->tm_hour, local->tm_min,
+               profileSets[i].profiles[profile].name);
+        status = 1;
+        continue;
+      }
+      const PhasePlan *plan = selectPlan(library, i, minute);
+      printf("Interseccion %d a las %02d:%02d: perfil %s, ciclo %.1f s\n", i,
+             local->tm_hour, local->tm_min,
+             profileSets[i].profiles[profile].name, plan->cycle / 10.0);
+    }
+    freePlanLibrary(library);
+  }
+
+  freeIntersections(numIntersections, graphs, profileSets);
+  return status;
+}
+
+/*
+ * Función: runPublish
+ * Modo `--publicar`: publica en memoria compartida el plan vigente de cada intersección.
+ *
+ * Descripción:
+ * Construye la biblioteca de planes igual que `--planes` y publica en el segmento PLAN_STORE_NAME el plan que rige
+ * en este minuto, usando como identificador la posición de la intersección en la línea de comandos. El segmento
+ * permanece disponible para otros procesos después de terminar.
+ */
+static int runPublish(int argc, char *argv[]) {
+  if (argc < 2 || argc % 2 != 0) {
+    return -1;
+  }
+  int numIntersections = argc / 2;
+  Graph **graphs;
+  DemandProfileSet *profileSets;
+  int status = loadIntersections(numIntersections, argv, &graphs, &profileSets);
+  PlanStore *store = status == 0 ? createPlanStore(PLAN_STORE_NAME) : NULL;
+
+  if (store != NULL) {
+    PlanLibrary *library =
+        buildPlanLibrary(graphs, profileSets, numIntersections,
+                         (int)sysconf(_SC_NPROCESSORS_ONLN));
+    if (library == NULL) {
+      status = 1;
+    }
+    time_t now = time(NULL);
+    struct tm *local = localtime(&now);
+    int minute = local->tm_hour * 60 + local->tm_min;
+    for (int i = 0; library != NULL && i < numIntersections; i++) {
+      int profile = library->schedule[i * MINUTES_PER_DAY + minute];
+      if (library->status[i * MAX_PROFILES + profile] != 0 ||
+          publishPlan(store, i, selectPlan(library, i, minute)) != 0) {
+        status = 1;
+        continue;
+      }
+      printf("Interseccion %d: perfil %s publicado en %s\n", i,
+             profileSets[i].profiles[profile].name, PLAN_STORE_NAME);
+    }
+    freePlanLibrary(library);
+    closePlanStore(store);
+  } else {
+    status = 1;
+  }
+
+  freeIntersections(numIntersections, graphs, profileSets);
+  return status;
+}
+
+/*
+ * Función: runRead
+ * Modo `--leer`: lee de memoria compartida el plan publicado de cada intersección pedida.
+ */
+static int runRead(int argc, char *argv[]) {
+  if (argc < 1) {
+    return -1;
+  }
+  const PlanStore *store = attachPlanStore(PLAN_STORE_NAME);
+  if (store == NULL) {
+    return 1;
+  }
+
+  int status = 0;
+  for (int a = 0; a < argc; a++) {
+    int intersection = atoi(argv[a]);
+    PhasePlan plan;
+    if (readPlan(store, intersection, &plan) != 0) {
+      printf("Interseccion %d: sin plan publicado\n", intersection);
+      status = 1;
+      continue;
+    }
+    printf("Interseccion %d:\n", intersection);
+    printPhasePlan(NULL, &plan);
+  }
+
+  detachPlanStore(store);
+  return status;
+}
+
+/*
+ * Función: runPreemption
+ * Modo `--preferencia`: muestra el camino más rápido hacia el verde de un cruce desde cada fase del plan.
+ *
+ * Descripción:
+ * La tabla de preferencia depende del plan, así que se construye aquí para el plan que se muestra.
+ */
+static int runPreemption(int argc, char *argv[]) {
+  if (argc != 2) {
+    return -1;
+  }
+  Graph *graph = readGraphFromFile(argv[0]);
+  if (graph == NULL) {
+    return 1;
+  }
+  int movement = getIndex(graph, argv[1]);
+  if (movement == -1) {
+    printf("Error: El cruce %s no existe.\n", argv[1]);
+    freeGraph(graph);
+    return 1;
+  }
+  PhasePlan plan;
+  if (buildPhasePlan(graph, NULL, &plan) != 0) {
+    printf("Error: No hay un plan valido para la tabla de preferencia: excede "
+           "%d cruces o %d fases, o junta cruces incompatibles.\n",
+           PLAN_MAX_MOVEMENTS, PLAN_MAX_PHASES);
+    freeGraph(graph);
+    return 1;
+  }
+
+  PreemptionTable *table = (PreemptionTable *)malloc(sizeof(PreemptionTable));
+  if (table == NULL) {
+    printf("Error: No se pudo asignar la tabla de preferencia en memoria.\n");
+    freeGraph(graph);
+    return 1;
+  }
+  traceEvent(TRACE_STAGE_BEGIN, STAGE_PREEMPTION, 0);
+  buildPreemptionTable(&plan, table);
+  traceEvent(TRACE_STAGE_END, STAGE_PREEMPTION, 0);
+  printPhasePlan(graph, &plan);
+  for (int p = 0; p < plan.numPhases; p++) {
+    const PreemptionEntry *entry = preemptionLookup(table, p, movement);
+    printf("Desde fase %d: ", p + 1);
+    if (entry->targetPhase == PREEMPTION_NONE) {
+      printf("ninguna fase sirve a %s\n", argv[1]);
+      continue;
+    }
+    int phase = p;
+    while (phase != entry->targetPhase) {
+      phase = table->nextHop[phase][entry->targetPhase];
+      printf("-> fase %d ", phase + 1);
+    }
+    printf("(verde para %s en %.1f s)\n", argv[1], entry->time / 10.0);
+  }
+
+  free(table);
+  freeGraph(graph);
+  return 0;
+}
+
+/*
+ * Función: runSweep
+ * Modo `--barrido`: evalúa el plan de cada perfil de demanda con el barrido de Monte Carlo.
+ */
+static int runSweep(int argc, char *argv[]) {
+  if (argc < 2 || argc > 3) {
+    return -1;
+  }
+  Graph *graph = readGraphFromFile(argv[0]);
+  DemandProfileSet profileSet;
+  if (graph == NULL || readDemandProfiles(argv[1], graph, &profileSet) != 0) {
+    freeGraph(graph);
+    return 1;
+  }
+
+  SweepConfig config;
+  defaultSweepConfig(&config);
+  config.numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (argc == 3) {
+    config.numScenarios = atoi(argv[2]);
+  }
+  if (config.numScenarios < 1) {
+    freeDemandProfiles(&profileSet);
+    freeGraph(graph);
+    return -1;
+  }
+
+  int status = 0;
+  for (int p = 0; p < profileSet.numProfiles && status == 0; p++) {
+    DemandProfile *profile = &profileSet.profiles[p];
+    PhasePlan plan;
+    SweepResult result;
+    if (buildPhasePlan(graph, profile->flows, &plan) != 0) {
+      printf("Perfil %s: el plan excede los limites o no es seguro.\n", profile->name);
+      continue;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (runMonteCarloSweep(graph, &plan, profile->flows, &config, &result) !=
+        0) {
+      status = 1;
+      break;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    printf("Perfil %s: ciclo %.1f s, %d escenarios de %d s en %.1f ms\n",
+           profile->name, plan.cycle / 10.0, config.numScenarios,
+           config.horizon,
+           (end.tv_sec - start.tv_sec) * 1e3 +
+               (end.tv_nsec - start.tv_nsec) / 1e6);
+    printSweepResult(&result);
+  }
+
+  freeDemandProfiles(&profileSet);
+  freeGraph(graph);
+  return status;
+}
+
+/*
+ * Función: readProfileFlows
+ * Lee un archivo de perfiles y devuelve la demanda del perfil con el nombre indicado.
+ *
+ * Retorno:
+ * - La demanda del perfil, que pertenece a profileSet y se libera con freeDemandProfiles().
+ * - NULL si el archivo no se pudo leer o el perfil no existe; profileSet queda vacío.
+ */
+static const double *readProfileFlows(char *filename, char *name,
+                                      Graph *graph,
+                                      DemandProfileSet *profileSet) {
+  if (readDemandProfiles(filename, graph, profileSet) != 0) {
+    return NULL;
+  }
+  for (int p = 0; p < profileSet->numProfiles; p++) {
+    if (strcmp(profileSet->profiles[p].name, name) == 0) {
+      return profileSet->profiles[p].flows;
+    }
+  }
+  printf("Error: El perfil %s no existe.\n", name);
+  freeDemandProfiles(profileSet);
+  return NULL;
+}
+
+/*
+ * Función: runExport
+ * Modo `--exportar`: genera el módulo de C del plan de un cruce, opcionalmente temporizado con un perfil de demanda.
+ */
+static int runExport(int argc, char *argv[]) {
+  if (argc != 2 && argc != 4) {
+    return -1;
+  }
+  Graph *graph = readGraphFromFile(argv[0]);
+  if (graph == NULL) {
+    return 1;
+  }
+
+  DemandProfileSet profileSet = {0};
+  const double *flows = NULL;
+  if (argc == 4 &&
+      (flows = readProfileFlows(argv[2], argv[3], graph, &profileSet)) ==
+          NULL) {
+    freeGraph(graph);
+    return 1;
+  }
+
+  int status = 0;
+  PhasePlan plan;
+  if (buildPhasePlan(graph, flows, &plan) != 0) {
+    printf("Error: El plan excede %d cruces o %d fases, o junta cruces "
+           "incompatibles.\n",
+           PLAN_MAX_MOVEMENTS, PLAN_MAX_PHASES);
+    status = 1;
+  } else if (exportPhasePlan(graph, &plan, argv[1]) != 0) {
+    status = 1;
+  } else {
+    printPhasePlan(graph, &plan);
+    printf("Plan exportado a %s/%s.h y %s.c\n", CODEGEN_DIRECTORY, argv[1],
+           argv[1]);
+  }
+
+  freeDemandProfiles(&profileSet);
+  freeGraph(graph);
+  return status;
+}
+
+/*
+ * Función: printGrouping
+ * Imprime la suma de razones críticas, el tiempo perdido y los conflictos de una agrupación.
+ */
+static double printGrouping(char *title, Graph *graph, const double *flows,
+                            GroupList *groupList, double lostTime) {
+  double ratio = criticalFlowRatio(graph, flows, groupList);
+  int conflicts = countGroupConflicts(graph, groupList);
+  printf("%s: Y = %.3f, tiempo perdido %.1f s", title, ratio, lostTime);
+  if (conflicts < 0) {
+    printf(", sin verificar los conflictos");
+  } else if (conflicts > 0) {
+    printf(", %d pares incompatibles en la misma fase", conflicts);
+  }
+  printf("\n");
+  printGroupList(groupList);
+  return ratio;
+}
+
+/*
+ * Función: runWeighted
+ * Modo `--ponderar`: compara la agrupación ponderada por demanda con la agrupación original.
+ *
+ * Descripción:
+ * La demanda se toma del perfil indicado o, si no se indica, de la sección [flujos] del grafo. Se muestran dos
+ * agrupaciones, ambas con las mismas etapas de traslape y secuencia: la original de buildGroupList(), que no usa
+ * la demanda, y la de buildWeightedGroupList(). La ganancia de capacidad es el cociente de sus sumas de razones
+ * críticas.
+ */
+static int runWeighted(int argc, char *argv[]) {
+  if (argc != 1 && argc != 3) {
+    return -1;
+  }
+  Graph *graph = readGraphFromFile(argv[0]);
+  if (graph == NULL) {
+    return 1;
+  }
+
+  DemandProfileSet profileSet = {0};
+  const double *flows = graph->flow;
+  if (argc == 3) {
+    flows = readProfileFlows(argv[1], argv[2], graph, &profileSet);
+  } else if (flows == NULL) {
+    printf("Error: El grafo no tiene seccion [flujos]; indique un perfil.\n");
+  }
+  if (flows == NULL) {
+    freeGraph(graph);
+    return 1;
+  }
+
+  GroupList original, weighted;
+  double originalLost = 0, weightedLost = 0;
+  bool planned = planGroups(graph, NULL, &original, &originalLost, NULL);
+  planned = planGroups(graph, flows, &weighted, &weightedLost, NULL) && planned;
+
+  int status = 0;
+  if (!planned) {
+    printf("Error: No se pudieron planificar las fases.\n");
+    status = 1;
+  } else {
+    double originalRatio = printGrouping("Original", graph, flows, &original,
+                                         originalLost);
+    double weightedRatio = printGrouping("Ponderada por demanda", graph,
+                                         flows, &weighted, weightedLost);
+    if (originalRatio > 0 && weightedRatio > 0) {
+      printf("Ganancia de capacidad sobre el plan original: %+.1f%%\n",
+             (originalRatio / weightedRatio - 1) * 100);
+    }
+  }
+
+  freeGroupList(&original);
+  freeGroupList(&weighted);
+  freeDemandProfiles(&profileSet);
+  freeGraph(graph);
+  return status;
+}
+
+/*
+ * Función: runControllers
+ * Modo `--controladores`: ejecuta muchas intersecciones con los planes de un cruce.
+ *
+ * Descripción:
+ * Construye el plan de cada perfil de demanda del cruce y crea INTERSECCIONES controladores que usan los perfiles
+ * por turnos, repartidos en HILOS fragmentos (uno por núcleo por defecto). Corre SEGUNDOS (10 por defecto) en tiempo
+ * real, o tan rápido como se pueda con `simulado`, y muestra las métricas de cada fragmento.
+ */
+static int runControllers(int argc, char *argv[]) {
+  if (argc < 3 || argc > 6) {
+    return -1;
+  }
+  int numIntersections = atoi(argv[2]);
+  double seconds = argc > 3 ? atof(argv[3]) : 10;
+  RuntimeConfig config;
+  config.numShards =
+      argc > 4 ? atoi(argv[4]) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  config.duration = (uint64_t)(seconds * 1000 / CONTROLLER_TICK_MS);
+  config.realTime = !(argc > 5 && strcmp(argv[5], "simulado") == 0);
+  config.pinThreads = true;
+  config.numSnapshots = 0;
+  if (numIntersections < 1 || config.duration == 0) {
+    return -1;
+  }
+
+  Graph **graphs;
+  DemandProfileSet *profileSets;
+  if (loadIntersections(1, argv, &graphs, &profileSets) != 0) {
+    freeIntersections(1, graphs, profileSets);
+    return 1;
+  }
+  PlanLibrary *library = buildPlanLibrary(graphs, profileSets, 1, 1);
+  int valid[MAX_PROFILES];
+  int numValid = 0;
+  for (int p = 0; library != NULL && p < library->numProfiles[0]; p++) {
+    if (library->status[p] == 0) {
+      valid[numValid++] = p;
+    }
+  }
+
+  int status = 1;
+  const PhasePlan **plans = NULL;
+  const double **flows = NULL;
+  if (library != NULL && numValid == 0) {
+    printf("Error: Ningun perfil tiene un plan valido.\n");
+  } else if (library != NULL) {
+    plans = (const PhasePlan **)malloc(numIntersections * sizeof(PhasePlan *));
+    flows = (const double **)malloc(numIntersections * sizeof(double *));
+    if (plans == NULL || flows == NULL) {
+      printf("Error: No se pudo asignar los planes de las intersecciones en "
+             "memoria.\n");
+    }
+  }
+  if (plans != NULL && flows != NULL) {
+    for (int i = 0; i < numIntersections; i++) {
+      int profile = valid[i % numValid];
+      plans[i] = getLibraryPlan(library, 0, profile);
+      flows[i] = profileSets[0].profiles[profile].flows;
+    }
+
+    Runtime *runtime =
+        createRuntime(&config, plans, flows, numIntersections);
+    if (runtime != NULL && startRuntime(runtime) == 0) {
+      printf("%d intersecciones en %d hilos durante %.1f s%s...\n",
+             numIntersections, runtime->config.numShards, seconds,
+             config.realTime ? "" : " simulados");
+      struct timespec start, end;
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      waitRuntime(runtime);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+      printRuntimeMetrics(runtime);
+      printf("Tiempo real transcurrido: %.2f s\n",
+             (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+      status = 0;
+    }
+    freeRuntime(runtime);
+  }
+
+  free(flows);
+  free(plans);
+  freePlanLibrary(library);
+  freeIntersections(1, graphs, profileSets);
+  return status;
+}
+
+/*
+ * Función: runRecord
+ * Modo `--grabar`: genera una grabación sintética de detecciones para un cruce.
+ *
+ * Descripción:
+ * Las llegadas siguen la demanda del perfil vigente en cada minuto según el horario de los perfiles. La grabación
+ * dura HORAS (24 por defecto) desde medianoche y la misma SEMILLA (1 por defecto) produce el mismo archivo.
+ */
+static int runRecord(int argc, char *argv[]) {
+  if (argc < 3 || argc > 5) {
+    return -1;
+  }
+  double hours = argc > 3 ? atof(argv[3]) : 24;
+  uint64_t seed = argc > 4 ? strtoull(argv[4], NULL, 10) : 1;
+  if (hours <= 0) {
+    return -1;
+  }
+
+  Graph **graphs;
+  DemandProfileSet *profileSets;
+  int status = loadIntersections(1, argv, &graphs, &profileSets);
+  if (status == 0) {
+    PlanLibrary *library = buildPlanLibrary(graphs, profileSets, 1, 1);
+    uint64_t durationMs = (uint64_t)(hours * 3600000);
+    int count =
+        library == NULL
+            ? -1
+            : synthesizeRecording(argv[2], &profileSets[0], library->schedule,
+                                  graphs[0]->numVertices, durationMs, seed);
+    FILE *file = count < 0 ? NULL : fopen(argv[2], "rb");
+    long size = -1;
+    if (file != NULL) {
+      if (fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+      }
+      fclose(file);
+    }
+    if (count < 0) {
+      status = 1;
+    } else if (size < 0) {
+      printf("Error: No se pudo leer el tamano de la grabacion %s.\n", argv[2]);
+      status = 1;
+    } else {
+      printf("%d detecciones en %.1f h grabadas en %s (%ld bytes, %.2f "
+             "bytes por deteccion)\n",
+             count, hours, argv[2], size,
+             count > 0 ? (double)(size - (long)sizeof(RecordingHeader)) / count
+                       : 0.0);
+    }
+    freePlanLibrary(library);
+  }
+
+  freeIntersections(1, graphs, profileSets);
+  return status;
+}
+
+/*
+ * Función: runReplay
+ * Modo `--reproducir`: reproduce una grabación con varios planes del cruce y compara los resultados.
+ *
+ * Descripción:
+ * Las columnas son el plan del grafo sin perfiles, el horario de la biblioteca (que cambia de plan al terminar
+ * el verde de la última fase cuando cambia el perfil vigente) y el plan fijo de cada perfil indicado, o de todos si
+ * no se indica ninguno. Todas las reproducciones usan tiempo virtual, así que el resultado es reproducible y solo se mide el
+ * tiempo real que tardan.
+ */
+static int runReplay(int argc, char *argv[]) {
+  if (argc < 3) {
+    return -1;
+  }
+  Graph **graphs;
+  DemandProfileSet *profileSets;
+  Recording *recording = NULL;
+  int status = loadIntersections(1, argv, &graphs, &profileSets);
+  if (status == 0 && (recording = loadRecording(argv[2])) == NULL) {
+    status = 1;
+  }
+  if (status != 0) {
+    freeIntersections(1, graphs, profileSets);
+    return status;
+  }
+
+  PlanLibrary *library = buildPlanLibrary(graphs, profileSets, 1, 1);
+  int maxColumns = 2 + MAX_PROFILES + (argc - 3);
+  char **names = (char **)malloc(maxColumns * sizeof(char *));
+  ReplayConfig *configs =
+      (ReplayConfig *)calloc(maxColumns, sizeof(ReplayConfig));
+  int count = 0;
+
+  PhasePlan graphPlan;
+  if (buildPhasePlan(graphs[0], NULL, &graphPlan) == 0) {
+    names[count] = "Grafo";
+    configs[count++].plan = &graphPlan;
+  }
+  names[count] = "Horario";
+  configs[count].library = library;
+  configs[count++].plan = NULL;
+  for (int p = 0; p < profileSets[0].numProfiles; p++) {
+    char *name = profileSets[0].profiles[p].name;
+    int selected = argc == 3;
+    for (int a = 3; a < argc; a++) {
+      selected |= strcmp(argv[a], name) == 0;
+    }
+    if (!selected) {
+      continue;
+    }
+    if (library->status[p] != 0) {
+      printf("Perfil %s: el plan excede los limites o no es seguro.\n", name);
+      continue;
+    }
+    names[count] = name;
+    configs[count++].plan = getLibraryPlan(library, 0, p);
+  }
+
+  for (int a = 3; a < argc; a++) {
+    int found = 0;
+    for (int p = 0; p < profileSets[0].numProfiles; p++) {
+      found |= strcmp(argv[a], profileSets[0].profiles[p].name) == 0;
+    }
+    if (!found) {
+      printf("Error: El perfil %s no existe.\n", argv[a]);
+    }
+  }
+
+  ReplaySummary *summaries =
+      (ReplaySummary *)malloc(count * sizeof(ReplaySummary));
+  const PhasePlan **plans =
+      (const PhasePlan **)malloc(count * sizeof(PhasePlan *));
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int k = 0; k < count && status == 0; k++) {
+    plans[k] = configs[k].plan;
+    if (replayRecording(recording, &configs[k], &summaries[k]) != 0) {
+      status = 1;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (status == 0) {
+    double elapsed =
+        (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    double simulated = recording->header.durationMs / 1e3 * count;
+    printf("%lu detecciones, %.1f h de trafico reproducidas %d veces en %.1f "
+           "ms (%.0f veces el tiempo real)\n",
+           (unsigned long)recording->header.numEvents,
+           recording->header.durationMs / 3.6e6, count, elapsed * 1e3,
+           elapsed > 0 ? simulated / elapsed : 0.0);
+    printReplayComparison(names, plans, summaries, count);
+  }
+
+  free(plans);
+  free(summaries);
+  free(configs);
+  free(names);
+  freePlanLibrary(library);
+  freeRecording(recording);
+  freeIntersections(1, graphs, profileSets);
+  return status;
+}
 
 int main(int argc, char *argv[]) {
+  char *program = argv[0];
+  if (argc > 2 && strcmp(argv[1], "--traza") == 0) {
+    // Los eventos se vuelcan al archivo al terminar el programa
+    traceStart(argv[2]);
+    argc -= 2;
+    argv += 2;
+  }
+  if (argc > 1) {
+    int status = -1;
+    if (strcmp(argv[1], "--planes") == 0) {
+      status = runPlanLibrary(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--preferencia") == 0) {
+      status = runPreemption(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--barrido") == 0) {
+      status = runSweep(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--exportar") == 0) {
+      status = runExport(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--publicar") == 0) {
+      status = runPublish(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--leer") == 0) {
+      status = runRead(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--ponderar") == 0) {
+      status = runWeighted(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--controladores") == 0) {
+      status = runControllers(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--grabar") == 0) {
+      status = runRecord(argc - 2, argv + 2);
+    } else if (strcmp(argv[1], "--reproducir") == 0) {
+      status = runReplay(argc - 2, argv + 2);
+    }
+    if (status == -1) {
+      printUsage(program);
+      return 1;
+    }
+    return status;
+  }
   iniciarMenu();
   return 0;
 }
@@ -0,0 +1,437 @@
+#include "monte_carlo.h"
+#include "bitset.h"
+#include "graph.h"
+#include "phase_plan.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SCENARIO_CHUNK 16 // Escenarios que toma un hilo cada vez
+#define LANES 8           // Relleno de los arreglos para vectorizar
+
+// Generador xorshift64*; cada hilo tiene el suyo y lo vuelve a sembrar al
+// empezar cada escenario, por lo que el resultado no depende de los hilos
+typedef struct Rng {
+  uint64_t state;
+} Rng;
+
+static uint64_t splitMix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+static inline uint64_t rngNext(Rng *rng) {
+  rng->state ^= rng->state >> 12;
+  rng->state ^= rng->state << 25;
+  rng->state ^= rng->state >> 27;
+  return rng->state * 0x2545f4914f6cdd1dull;
+}
+
+static inline float rngUniform(Rng *rng) {
+  return (float)(rngNext(rng) >> 40) * (1.0f / 16777216.0f);
+}
+
+static double rngGaussian(Rng *rng) {
+  double u1 = (rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+  double u2 = (rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+  return sqrt(-2.0 * log(u1 + 1e-300)) * cos(2.0 * M_PI * u2);
+}
+
+// Estado de la simulación en estructura de arreglos: cada arreglo tiene un
+// valor por cruce, relleno hasta múltiplo de LANES con ceros
+typedef struct QueueState {
+  _Alignas(64) float queue[PLAN_MAX_MOVEMENTS];
+  _Alignas(64) float arrivalProbability[PLAN_MAX_MOVEMENTS];
+  _Alignas(64) float uniform[PLAN_MAX_MOVEMENTS];
+  _Alignas(64) float delay[PLAN_MAX_MOVEMENTS];
+  _Alignas(64) float served[PLAN_MAX_MOVEMENTS];
+  _Alignas(64) float maxQueue[PLAN_MAX_MOVEMENTS];
+} QueueState;
+
+// Datos compartidos (solo lectura) y resultados por escenario
+typedef struct SweepJobs {
+  const SweepConfig *config;
+  const double *flows;
+  int numMovements;
+  int lanes;
+  int cycleSeconds;
+  float *dischargeRate; // [segundo del ciclo][cruce]: veh/s si tiene verde
+  int *approach;        // Acceso (origen) de cada cruce
+  int numApproaches;
+  atomic_int nextScenario;
+  atomic_int completed; // Escenarios simulados
+  double *delay;
+  double *maxQueue;
+  double *throughput;
+} SweepJobs;
+
+/*
+ * Función: defaultSweepConfig
+ * Llena la configuración con valores por defecto: 2000 escenarios de una hora, 15% de variación de demanda y
+ * 30% de variación del reparto de giros.
+ */
+void defaultSweepConfig(SweepConfig *config) {
+  config->numScenarios = 2000;
+  config->horizon = 3600;
+  config->demandSpread = 0.15;
+  config->shareSpread = 0.30;
+  config->seed = 20240611;
+  config->numThreads = 1;
+}
+
+/*
+ * Función: buildDischargeTimeline
+ * Calcula, para cada segundo del ciclo, la tasa de salida de cada cruce.
+ *
+ * Descripción:
+ * Durante el verde de la fase k salen SATURATION_FLOW / 3600 veh/s de sus cruces. Durante el despeje hacia la fase
+ * k + 1 solo siguen saliendo los cruces que tienen verde en ambas fases (traslape).
+ */
+static float *buildDischargeTimeline(const PhasePlan *plan, int lanes,
+                                     int *cycleSeconds) {
+  int seconds = (plan->cycle + 5) / 10;
+  if (seconds < 1) {
+    seconds = 1;
+  }
+  float *rate = (float *)calloc((size_t)seconds * lanes, sizeof(float));
+  if (rate == NULL) {
+    return NULL;
+  }
+  float saturation = (float)(SATURATION_FLOW / 3600.0);
+
+  for (int t = 0; t < seconds; t++) {
+    int tenth = t * 10 + 5; // Mitad del segundo
+    uint64_t green = 0;
+    int position = 0;
+    for (int k = 0; k < plan->numPhases; k++) {
+      int next = (k + 1) % plan->numPhases;
+      if (tenth < position + plan->green[k]) {
+        green = plan->phaseMask[k];
+        break;
+      }
+      position += plan->green[k];
+      int clearance = plan->numPhases > 1 ? plan->intergreen[k][next] : 0;
+      if (tenth < position + clearance) {
+        green = plan->phaseMask[k] & plan->phaseMask[next];
+        break;
+      }
+      position += clearance;
+    }
+    for (int m = 0; m < plan->numMovements; m++) {
+      rate[t * lanes + m] = bitsetTest(&green, m) ? saturation : 0;
+    }
+  }
+  *cycleSeconds = seconds;
+  return rate;
+}
+
+/*
+ * Función: simulateScenario
+ * Simula un escenario aleatorio y guarda su demora media, cola máxima y volumen atendido.
+ *
+ * Descripción:
+ * La demanda de todos los cruces se multiplica por un factor normal de media 1, y el reparto de giros de cada
+ * acceso se perturba de manera uniforme manteniendo el total del acceso. Después se avanza de a un segundo: llega un
+ * vehículo a cada cruce con probabilidad demanda / 3600 y la cola sale a la tasa de saturación mientras el cruce
+ * tiene verde. El ciclo interno recorre arreglos contiguos sin saltos para que el compilador lo vectorice.
+ */
+static void simulateScenario(SweepJobs *jobs, int scenario, QueueState *state,
+                             Rng *rng) {
+  const SweepConfig *config = jobs->config;
+  int n = jobs->numMovements;
+  int lanes = jobs->lanes;
+  rng->state = splitMix64(config->seed ^ splitMix64((uint64_t)scenario + 1));
+
+  double factor = 1.0 + config->demandSpread * rngGaussian(rng);
+  if (factor < 0.2) {
+    factor = 0.2;
+  }
+
+  double share[PLAN_MAX_MOVEMENTS];
+  double approachBase[PLAN_MAX_MOVEMENTS] = {0};
+  double approachNew[PLAN_MAX_MOVEMENTS] = {0};
+  for (int m = 0; m < n; m++) {
+    double spread = config->shareSpread * (2.0 * rngUniform(rng) - 1.0);
+    share[m] = jobs->flows[m] * (1.0 + spread);
+    approachBase[jobs->approach[m]] += jobs->flows[m];
+    approachNew[jobs->approach[m]] += share[m];
+  }
+
+  memset(state, 0, sizeof(QueueState));
+  for (int m = 0; m < n; m++) {
+    int a = jobs->approach[m];
+    double flow = approachNew[a] > 0
+                      ? share[m] / approachNew[a] * approachBase[a] * factor
+                      : 0;
+    double probability = flow / 3600.0;
+    state->arrivalProbability[m] = (float)(probability > 1 ? 1 : probability);
+  }
+
+  int cycle = jobs->cycleSeconds;
+  float arrivals = 0;
+  for (int t = 0; t < config->horizon; t++) {
+    const float *rate = &jobs->dischargeRate[(t % cycle) * lanes];
+    for (int m = 0; m < lanes; m++) {
+      state->uniform[m] = rngUniform(rng);
+    }
+    for (int m = 0; m < lanes; m++) {
+      float arrive = state->uniform[m] < state->arrivalProbability[m] ? 1.0f
+                                                                      : 0.0f;
+      float queue = state->queue[m] + arrive;
+      float depart = queue < rate[m] ? queue : rate[m];
+      queue -= depart;
+      state->queue[m] = queue;
+      state->delay[m] += queue;
+      state->served[m] += depart;
+      state->maxQueue[m] = queue > state->maxQueue[m] ? queue
+                                                      : state->maxQueue[m];
+      arrivals += arrive;
+    }
+  }
+
+  double delay = 0, served = 0, maxQueue = 0;
+  for (int m = 0; m < n; m++) {
+    delay += state->delay[m];
+    served += state->served[m];
+    if (state->maxQueue[m] > maxQueue) {
+      maxQueue = state->maxQueue[m];
+    }
+  }
+  jobs->delay[scenario] = arrivals > 0 ? delay / arrivals : 0;
+  jobs->maxQueue[scenario] = maxQueue;
+  jobs->throughput[scenario] = served * 3600.0 / config->horizon;
+}
+
+/*
+ * Función: sweepWorker
+ * Toma bloques de escenarios del contador compartido hasta agotarlos.
+ *
+ * Descripción:
+ * Si no hay memoria para su estado el hilo termina sin tomar escenarios; los demás hilos hacen su parte y
+ * runMonteCarloSweep() detecta con `completed` si quedó alguno sin simular.
+ */
+static void *sweepWorker(void *arg) {
+  SweepJobs *jobs = (SweepJobs *)arg;
+  QueueState *state = (QueueState *)aligned_alloc(64, sizeof(QueueState));
+  if (state == NULL) {
+    return NULL;
+  }
+  Rng rng;
+  int first;
+  while ((first = atomic_fetch_add(&jobs->nextScenario, SCENARIO_CHUNK)) <
+         jobs->config->numScenarios) {
+    int last = first + SCENARIO_CHUNK;
+    if (last > jobs->config->numScenarios) {
+      last = jobs->config->numScenarios;
+    }
+    for (int s = first; s < last; s++) {
+      simulateScenario(jobs, s, state, &rng);
+    }
+    atomic_fetch_add(&jobs->completed, last - first);
+  }
+  free(state);
+  return NULL;
+}
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Función: buildApproaches
+ * Asigna a cada cruce el acceso (calle de origen) por el que llegan sus vehículos.
+ *
+ * Descripción:
+ * El grafo no guarda el acceso de cada cruce, así que se toma de la convención de nombres de los archivos de
+ * entrada: cada cruce se nombra con dos letras de origen y dos de destino (AOAE va de AO a AE). La convención se
+ * valida: todos los nombres deben tener cuatro caracteres, con origen distinto del destino, y cada origen debe ser
+ * también el destino de algún cruce (una calle por la que se entra es también una por la que se sale). Si algún
+ * nombre no la cumple, cada cruce se trata como su propio acceso, de modo que no se cambia el reparto de giros y
+ * solo varía la demanda global.
+ *
+ * Parámetros:
+ * - graph: Grafo del cruce.
+ * - approach: Arreglo de numVertices enteros donde se escribe el acceso de cada cruce.
+ *
+ * Retorno:
+ * - Número de accesos distintos.
+ */
+static int buildApproaches(Graph *graph, int *approach) {
+  int n = graph->numVertices;
+  bool valid = true;
+  for (int m = 0; m < n && valid; m++) {
+    const char *name = graph->adjacencyList[m]->name;
+    valid = strlen(name) == 4 && strncmp(name, name + 2, 2) != 0;
+    bool isExit = false;
+    for (int k = 0; k < n && valid && !isExit; k++) {
+      isExit = strncmp(graph->adjacencyList[k]->name + 2, name, 2) == 0;
+    }
+    valid = valid && isExit;
+  }
+  if (!valid) {
+    printf("Aviso: Los nombres de los cruces no son ORIGEN+DESTINO de dos "
+           "letras; no se varia el reparto de giros.\n");
+    for (int m = 0; m < n; m++) {
+      approach[m] = m;
+    }
+    return n;
+  }
+
+  int numApproaches = 0;
+  for (int m = 0; m < n; m++) {
+    approach[m] = numApproaches;
+    for (int k = 0; k < m; k++) {
+      if (strncmp(graph->adjacencyList[k]->name,
+                  graph->adjacencyList[m]->name, 2) == 0) {
+        approach[m] = approach[k];
+        break;
+      }
+    }
+    if (approach[m] == numApproaches) {
+      numApproaches++;
+    }
+  }
+  return numApproaches;
+}
+
+/*
+ * Función: summarize
+ * Calcula media, intervalo de confianza del 95% de la media y percentiles de una muestra. Ordena la muestra.
+ */
+static void summarize(double *values, int count, Distribution *distribution) {
+  double sum = 0, sumSquares = 0;
+  for (int k = 0; k < count; k++) {
+    sum += values[k];
+  }
+  double mean = sum / count;
+  for (int k = 0; k < count; k++) {
+    sumSquares += (values[k] - mean) * (values[k] - mean);
+  }
+  double halfWidth =
+      count > 1 ? 1.96 * sqrt(sumSquares / (count - 1)) / sqrt(count) : 0;
+
+  qsort(values, count, sizeof(double), compareDoubles);
+  distribution->mean = mean;
+  distribution->ciLow = mean - halfWidth;
+  distribution->ciHigh = mean + halfWidth;
+  distribution->p50 = values[(int)(0.50 * (count - 1))];
+  distribution->p95 = values[(int)(0.95 * (count - 1))];
+  distribution->p99 = values[(int)(0.99 * (count - 1))];
+}
+
+/*
+ * Función: runMonteCarloSweep
+ * Evalúa la robustez de un plan frente a miles de escenarios de demanda aleatoria.
+ *
+ * Descripción:
+ * Reparte los escenarios entre config->numThreads hilos. Cada escenario tiene su propia semilla derivada de
+ * config->seed, así que el resultado es el mismo con cualquier número de hilos. Los accesos se obtienen de los
+ * nombres de los cruces con buildApproaches().
+ *
+ * Parámetros:
+ * - graph: Grafo del cruce.
+ * - plan: Plan a evaluar.
+ * - flows: Demanda base de cada cruce en veh/h.
+ * - config: Parámetros del barrido.
+ * - result: Distribuciones resultantes.
+ *
+ * Retorno:
+ * - 0 si el barrido se completó.
+ * - -1 si los parámetros no son válidos, el plan no es del grafo o no hubo memoria.
+ */
+int runMonteCarloSweep(Graph *graph, const PhasePlan *plan,
+                       const double *flows, const SweepConfig *config,
+                       SweepResult *result) {
+  if (config->numScenarios < 1 || config->horizon < 1 ||
+      plan->numPhases == 0 || plan->numMovements != graph->numVertices) {
+    return -1;
+  }
+
+  SweepJobs jobs;
+  jobs.config = config;
+  jobs.flows = flows;
+  jobs.numMovements = plan->numMovements;
+  jobs.lanes = (plan->numMovements + LANES - 1) / LANES * LANES;
+  jobs.dischargeRate = buildDischargeTimeline(plan, jobs.lanes,
+                                              &jobs.cycleSeconds);
+  jobs.approach = (int *)malloc(plan->numMovements * sizeof(int));
+  jobs.delay = (double *)malloc(config->numScenarios * sizeof(double));
+  jobs.maxQueue = (double *)malloc(config->numScenarios * sizeof(double));
+  jobs.throughput = (double *)malloc(config->numScenarios * sizeof(double));
+  int numThreads = config->numThreads < 1 ? 1 : config->numThreads;
+  pthread_t *threads = (pthread_t *)malloc(numThreads * sizeof(pthread_t));
+  int status = -1;
+  if (jobs.dischargeRate == NULL || jobs.approach == NULL ||
+      jobs.delay == NULL || jobs.maxQueue == NULL || jobs.throughput == NULL ||
+      threads == NULL) {
+    printf("Error: No se pudo asignar el barrido en memoria.\n");
+  } else {
+    jobs.numApproaches = buildApproaches(graph, jobs.approach);
+    atomic_init(&jobs.nextScenario, 0);
+    atomic_init(&jobs.completed, 0);
+
+    int started = 0;
+    for (int t = 0; t < numThreads; t++) {
+      if (pthread_create(&threads[t], NULL, sweepWorker, &jobs) == 0) {
+        started++;
+      } else {
+        break;
+      }
+    }
+    if (started == 0) {
+      sweepWorker(&jobs);
+    }
+    for (int t = 0; t < started; t++) {
+      pthread_join(threads[t], NULL);
+    }
+
+    if (atomic_load(&jobs.completed) < config->numScenarios) {
+      printf("Error: No se pudo asignar el estado de los escenarios en "
+             "memoria.\n");
+    } else {
+      summarize(jobs.delay, config->numScenarios, &result->delay);
+      summarize(jobs.maxQueue, config->numScenarios, &result->maxQueue);
+      summarize(jobs.throughput, config->numScenarios, &result->throughput);
+      status = 0;
+    }
+  }
+
+  free(threads);
+  free(jobs.delay);
+  free(jobs.maxQueue);
+  free(jobs.throughput);
+  free(jobs.approach);
+  free(jobs.dischargeRate);
+  return status;
+}
+
+/*
+ * Función: printDistribution
+ * Imprime una línea con la media, su intervalo de confianza y los percentiles.
+ */
+static void printDistribution(const char *label, const char *unit,
+                              const Distribution *distribution) {
+  printf("  %-12s media %8.2f %-7s IC95 [%8.2f, %8.2f]  p50 %8.2f  p95 %8.2f  "
+         "p99 %8.2f\n",
+         label, distribution->mean, unit, distribution->ciLow,
+         distribution->ciHigh, distribution->p50, distribution->p95,
+         distribution->p99);
+}
+
+/*
+ * Función: printSweepResult
+ * Imprime las distribuciones de demora, cola máxima y volumen atendido.
+ */
+void printSweepResult(const SweepResult *result) {
+  printDistribution("Demora", "s/veh", &result->delay);
+  printDistribution("Cola maxima", "veh", &result->maxQueue);
+  printDistribution("Volumen", "veh/h", &result->throughput);
+}
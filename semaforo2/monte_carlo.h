@@ -0,0 +1,38 @@
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+#include "graph.h"
+#include "phase_plan.h"
+#include <stdint.h>
+
+// Parámetros del barrido de escenarios aleatorios
+typedef struct SweepConfig {
+  int numScenarios;
+  int horizon;         // Segundos simulados por escenario
+  double demandSpread; // Desviación estándar del factor de demanda global
+  double shareSpread;  // Variación máxima (+/-) del reparto de giros
+  uint64_t seed;
+  int numThreads;
+} SweepConfig;
+
+// Resumen de una distribución sobre los escenarios
+typedef struct Distribution {
+  double mean;
+  double ciLow, ciHigh; // Intervalo de confianza del 95% de la media
+  double p50, p95, p99;
+} Distribution;
+
+typedef struct SweepResult {
+  Distribution delay;      // Demora media por vehículo (s/veh)
+  Distribution maxQueue;   // Cola máxima de cualquier cruce (veh)
+  Distribution throughput; // Vehículos atendidos por hora
+} SweepResult;
+
+// Funciones a implementar en monte_carlo.c
+void defaultSweepConfig(SweepConfig *config);
+int runMonteCarloSweep(Graph *graph, const PhasePlan *plan,
+                       const double *flows, const SweepConfig *config,
+                       SweepResult *result);
+void printSweepResult(const SweepResult *result);
+
+#endif
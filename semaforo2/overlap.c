@@ -0,0 +1,316 @@
+#include "overlap.h"
+#include "bitset.h"
+#include "conflicts.h"
+#include "graph.h"
+#include "traffic_lights.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Función: removeDuplicateGroups
+ * Elimina de la lista los grupos con exactamente los mismos cruces que un grupo anterior.
+ *
+ * Descripción:
+ * Dos conjuntos maximales son iguales o no se contienen entre sí, así que después de extender los grupos basta con
+ * comparar la igualdad de sus conjuntos de bits.
+ *
+ * Retorno:
+ * - Número de grupos que quedan en la lista.
+ */
+static int removeDuplicateGroups(GroupList *groupList, uint64_t *sets,
+                                 int numGroups, int words) {
+  Group *previous = NULL;
+  Group *currentGroup = groupList->head;
+  int kept = 0;
+  for (int g = 0; g < numGroups; g++) {
+    Group *nextGroup = currentGroup->next;
+    bool duplicate = false;
+    for (int k = 0; k < kept && !duplicate; k++) {
+      duplicate = bitsetEqual(sets + (size_t)k * words,
+                              sets + (size_t)g * words, words);
+    }
+
+    if (duplicate) {
+      previous->next = nextGroup;
+      for (int i = 0; i < currentGroup->numTurns; i++) {
+        free(currentGroup->turns[i]);
+      }
+      free(currentGroup->turns);
+      free(currentGroup);
+    } else {
+      memmove(sets + (size_t)kept * words, sets + (size_t)g * words,
+              words * sizeof(uint64_t));
+      kept++;
+      previous = currentGroup;
+    }
+    currentGroup = nextGroup;
+  }
+  groupList->tail = previous;
+  return kept;
+}
+
+/*
+ * Función: splitConflictingGroups
+ * Separa de cada grupo los cruces incompatibles con otros del mismo grupo.
+ *
+ * Descripción:
+ * Los cruces de cada grupo se revisan en orden y se conservan los que no tienen conflicto con los ya conservados;
+ * los demás se mueven a un grupo nuevo al final de la lista, que a su vez se revisa al llegar a él. Así, sin
+ * importar cómo se formaron los grupos, todos quedan como conjuntos independientes y ningún cruce pierde su fase.
+ *
+ * Retorno:
+ * - Número de grupos nuevos creados.
+ * - -1 si no se pudo asignar memoria; los grupos que faltaban por revisar pueden seguir teniendo conflictos.
+ */
+static int splitConflictingGroups(Graph *graph, GroupList *groupList,
+                                  ConflictMatrix *conflicts) {
+  int words = conflicts->words;
+  uint64_t *kept = (uint64_t *)malloc(words * sizeof(uint64_t));
+  if (kept == NULL) {
+    printf("Error: No se pudo asignar el grupo en memoria.\n");
+    return -1;
+  }
+  int split = 0;
+  for (Group *group = groupList->head; group != NULL; group = group->next) {
+    char **moved = (char **)malloc((group->numTurns + 1) * sizeof(char *));
+    if (moved == NULL) {
+      printf("Error: No se pudo asignar el grupo en memoria.\n");
+      split = -1;
+      break;
+    }
+    bitsetClear(kept, words);
+    int numKept = 0, numMoved = 0;
+    for (int t = 0; t < group->numTurns; t++) {
+      int i = getIndex(graph, group->turns[t]);
+      if (i != -1 && bitsetIntersects(conflictRow(conflicts, i), kept, words)) {
+        moved[numMoved++] = group->turns[t];
+        continue;
+      }
+      if (i != -1) {
+        bitsetSet(kept, i);
+      }
+      group->turns[numKept++] = group->turns[t];
+    }
+
+    if (numMoved == 0) {
+      free(moved);
+      continue;
+    }
+    group->numTurns = numKept;
+    group->turns[numKept] = NULL;
+    moved[numMoved] = NULL;
+    addGroup(groupList, moved, numMoved);
+    split++;
+  }
+  free(kept);
+  return split;
+}
+
+/*
+ * Función: extendGroupsToMaximal
+ * Extiende cada grupo hasta un conjunto maximal de cruces compatibles (traslape de fases).
+ *
+ * Descripción:
+ * createGroups() asigna cada cruce a una sola fase, pero un cruce puede tener verde en todas las fases con las
+ * que no tenga conflictos. Primero se separan los cruces incompatibles que compartan un grupo
+ * (splitConflictingGroups()), para que cada grupo sea un conjunto independiente. Luego, para cada grupo se calcula
+ * el conjunto de cruces bloqueados (unión de las filas de conflicto de sus miembros) y se agregan, uno a uno, los
+ * cruces no bloqueados, comenzando por los que reciben verde en menos fases para repartir el beneficio. Cada cruce
+ * agregado bloquea a su vez a sus incompatibles, de modo que al terminar el grupo es un conjunto independiente
+ * maximal del grafo de conflictos. Si dos grupos quedan iguales se conserva solo el primero. Si se cancela, los
+ * grupos que faltan quedan sin extender (pero sin conflictos); lo mismo si falta memoria para agregar un cruce.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - groupList: Lista de grupos que se extenderá.
+ * - progress: Avance con la petición de cancelación, o NULL.
+ *
+ * Retorno:
+ * - Número de cruces agregados en total a los grupos.
+ * - -1 si no se pudo asignar memoria para la matriz de conflictos, para separar los grupos o para los conjuntos
+ *   de trabajo; en ese caso los grupos pueden seguir teniendo conflictos.
+ */
+int extendGroupsToMaximal(Graph *graph, GroupList *groupList,
+                          PlanningProgress *progress) {
+  int n = graph->numVertices;
+  ConflictMatrix *conflicts = buildConflictMatrix(graph);
+  if (conflicts == NULL) {
+    return -1;
+  }
+  if (splitConflictingGroups(graph, groupList, conflicts) < 0) {
+    freeConflictMatrix(conflicts);
+    return -1;
+  }
+  int numGroups = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    numGroups++;
+  }
+  if (numGroups == 0) {
+    freeConflictMatrix(conflicts);
+    return 0;
+  }
+
+  int words = conflicts->words;
+  uint64_t *sets =
+      (uint64_t *)malloc((size_t)numGroups * words * sizeof(uint64_t));
+  uint64_t *blocked = (uint64_t *)malloc(words * sizeof(uint64_t));
+  int *coverage = (int *)calloc(n, sizeof(int));
+  int *candidates = (int *)malloc(n * sizeof(int));
+  if (sets == NULL || blocked == NULL || coverage == NULL ||
+      candidates == NULL) {
+    printf("Error: No se pudo asignar el traslape en memoria.\n");
+    free(candidates);
+    free(coverage);
+    free(blocked);
+    free(sets);
+    freeConflictMatrix(conflicts);
+    return -1;
+  }
+
+  Group *currentGroup = groupList->head;
+  for (int g = 0; g < numGroups; g++) {
+    uint64_t *set = sets + (size_t)g * words;
+    groupToBitset(graph, currentGroup, set, words);
+    for (int i = 0; i < n; i++) {
+      coverage[i] += bitsetTest(set, i);
+    }
+    currentGroup = currentGroup->next;
+  }
+
+  int added = 0;
+  bool failed = false;
+  currentGroup = groupList->head;
+  for (int g = 0; g < numGroups && !failed && !planningCancelled(progress);
+       g++) {
+    uint64_t *set = sets + (size_t)g * words;
+    bitsetClear(blocked, words);
+    for (int i = 0; i < n; i++) {
+      if (bitsetTest(set, i)) {
+        bitsetOr(blocked, conflictRow(conflicts, i), words);
+      }
+    }
+
+    // Candidatos ordenados por el número de fases que ya los sirven
+    int numCandidates = 0;
+    for (int i = 0; i < n; i++) {
+      if (!bitsetTest(set, i) && !bitsetTest(blocked, i)) {
+        int k = numCandidates++;
+        while (k > 0 && coverage[candidates[k - 1]] > coverage[i]) {
+          candidates[k] = candidates[k - 1];
+          k--;
+        }
+        candidates[k] = i;
+      }
+    }
+
+    int groupAdded = 0;
+    for (int c = 0; c < numCandidates; c++) {
+      int i = candidates[c];
+      if (bitsetTest(blocked, i)) {
+        continue;
+      }
+      bitsetOr(blocked, conflictRow(conflicts, i), words);
+      candidates[groupAdded++] = i;
+    }
+
+    // El conjunto y la cobertura se actualizan solo con los cruces que sí se
+    // agregan al grupo, para que sigan coincidiendo si falta memoria
+    if (groupAdded > 0) {
+      char **turns = (char **)realloc(
+          currentGroup->turns,
+          (currentGroup->numTurns + groupAdded + 1) * sizeof(char *));
+      if (turns == NULL) {
+        printf("Error: No se pudo asignar el grupo en memoria.\n");
+        failed = true;
+        break;
+      }
+      currentGroup->turns = turns;
+      for (int c = 0; c < groupAdded; c++) {
+        int i = candidates[c];
+        char *name = strdup(graph->adjacencyList[i]->name);
+        if (name == NULL) {
+          printf("Error: No se pudo asignar el grupo en memoria.\n");
+          failed = true;
+          break;
+        }
+        currentGroup->turns[currentGroup->numTurns++] = name;
+        bitsetSet(set, i);
+        coverage[i]++;
+        added++;
+      }
+      currentGroup->turns[currentGroup->numTurns] = NULL;
+    }
+    currentGroup = currentGroup->next;
+  }
+
+  removeDuplicateGroups(groupList, sets, numGroups, words);
+
+  free(candidates);
+  free(coverage);
+  free(blocked);
+  free(sets);
+  freeConflictMatrix(conflicts);
+  return added;
+}
+
+/*
+ * Función: effectiveGreenRatios
+ * Calcula, para cada cruce, la fracción del ciclo en la que tiene verde.
+ *
+ * Descripción:
+ * Con el traslape un cruce tiene verde en todas las fases que lo incluyen, así que su verde efectivo es la suma del
+ * verde de esas fases; el despeje entre fases no cuenta como verde.
+ *
+ * Parámetros:
+ * - plan: Plan con los tiempos ya asignados.
+ *
+ * Retorno:
+ * - Arreglo de plan->numMovements valores entre 0 y 1 que debe liberarse con free().
+ * - NULL si no se pudo asignar memoria.
+ */
+double *effectiveGreenRatios(const PhasePlan *plan) {
+  double *ratios = (double *)calloc(plan->numMovements + 1, sizeof(double));
+  if (ratios == NULL) {
+    printf("Error: No se pudo asignar la proporcion de verde en memoria.\n");
+    return NULL;
+  }
+  for (int k = 0; k < plan->numPhases; k++) {
+    for (int i = 0; i < plan->numMovements; i++) {
+      if (bitsetTest(&plan->phaseMask[k], i)) {
+        ratios[i] += plan->green[k];
+      }
+    }
+  }
+  for (int i = 0; i < plan->numMovements && plan->cycle > 0; i++) {
+    ratios[i] /= plan->cycle;
+  }
+  return ratios;
+}
+
+/*
+ * Función: printGreenRatios
+ * Imprime el verde efectivo de cada cruce y su proporción del ciclo.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo, usado para los nombres.
+ * - plan: Plan con los tiempos ya asignados.
+ *
+ * Retorno: Ninguno.
+ */
+void printGreenRatios(Graph *graph, const PhasePlan *plan) {
+  double *ratios = effectiveGreenRatios(plan);
+  if (ratios == NULL) {
+    return;
+  }
+
+  printf("Proporcion de verde efectiva (ciclo de %.1f s):\r\n",
+         plan->cycle / 10.0);
+  for (int i = 0; i < plan->numMovements; i++) {
+    printf(" %s: %.1f s (%.2f)\r\n", graph->adjacencyList[i]->name,
+           ratios[i] * plan->cycle / 10.0, ratios[i]);
+  }
+  printf("\r\n");
+  free(ratios);
+}
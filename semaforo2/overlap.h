@@ -0,0 +1,14 @@
+#ifndef OVERLAP_H
+#define OVERLAP_H
+
+#include "graph.h"
+#include "phase_plan.h"
+#include "traffic_lights.h"
+
+// Funciones a implementar en overlap.c
+int extendGroupsToMaximal(Graph *graph, GroupList *groupList,
+                          PlanningProgress *progress);
+double *effectiveGreenRatios(const PhasePlan *plan);
+void printGreenRatios(Graph *graph, const PhasePlan *plan);
+
+#endif
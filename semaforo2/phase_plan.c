@@ -0,0 +1,253 @@
+#include "phase_plan.h"
+#include "bitset.h"
+#include "conflicts.h"
+#include "graph.h"
+#include "sequencing.h"
+#include "trace.h"
+#include "traffic_lights.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Función: toTenths
+ * Convierte segundos a décimas de segundo redondeando al entero más cercano.
+ */
+static uint16_t toTenths(double seconds) {
+  double tenths = seconds * 10 + 0.5;
+  if (tenths < 0) {
+    return 0;
+  }
+  if (tenths > UINT16_MAX) {
+    return UINT16_MAX;
+  }
+  return (uint16_t)tenths;
+}
+
+/*
+ * Función: buildPhasePlan
+ * Calcula el plan de fases completo de un cruce: agrupación, traslape, secuencia y tiempos.
+ *
+ * Descripción:
+ * Ejecuta las mismas etapas que createGroups() con planGroups(), sin imprimir nada, y convierte los grupos
+ * resultantes en el plan con planFromGroupList(): máscaras de bits, despeje entre cada par de fases y tiempos de
+ * verde con computeTiming(). No usa variables globales, por lo que puede llamarse desde varios hilos a la vez
+ * sobre el mismo grafo.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo del cruce.
+ * - flows: Demanda de cada cruce en veh/h (numVertices valores), o NULL para usar la sección [flujos] del grafo.
+ *   Con demanda las fases se agrupan con buildWeightedGroupList(); sin demanda se usa la agrupación original de
+ *   buildGroupList() y el verde se reparte en partes iguales.
+ * - plan: Plan donde se escribe el resultado.
+ *
+ * Retorno:
+ * - 0 si el plan se construyó correctamente.
+ * - -1 si el grafo excede PLAN_MAX_MOVEMENTS cruces, el plan excede PLAN_MAX_PHASES fases, alguna fase junta
+ *   cruces incompatibles según la matriz de conflictos simétrica o no hubo memoria para verificarlo.
+ */
+int buildPhasePlan(Graph *graph, const double *flows, PhasePlan *plan) {
+  if (graph->numVertices > PLAN_MAX_MOVEMENTS) {
+    return -1;
+  }
+
+  if (flows == NULL) {
+    flows = graph->flow;
+  }
+
+  GroupList groupList;
+  if (!planGroups(graph, flows, &groupList, NULL, NULL)) {
+    return -1;
+  }
+
+  int numGroups = 0;
+  for (Group *g = groupList.head; g != NULL; g = g->next) {
+    numGroups++;
+  }
+  // Un plan con cruces incompatibles en la misma fase no debe llegar a ejecutarse
+  if (numGroups > PLAN_MAX_PHASES ||
+      countGroupConflicts(graph, &groupList) != 0) {
+    freeGroupList(&groupList);
+    return -1;
+  }
+
+  int status = planFromGroupList(graph, &groupList, flows, plan);
+  freeGroupList(&groupList);
+  return status;
+}
+
+/*
+ * Función: planFromGroupList
+ * Convierte una lista de grupos ya planificada en un plan compacto con sus tiempos.
+ *
+ * Descripción:
+ * Cada grupo pasa a ser una fase, en el orden de la lista: se guarda su máscara de cruces, el despeje hacia cada
+ * otra fase y, con computeTiming(), el verde y el ciclo. No revisa los conflictos dentro de las fases.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo del cruce.
+ * - groupList: Lista de grupos planificada.
+ * - flows: Demanda de cada cruce en veh/h, o NULL para repartir el verde en partes iguales.
+ * - plan: Plan donde se escribe el resultado.
+ *
+ * Retorno:
+ * - 0 si el plan se construyó correctamente.
+ * - -1 si excede PLAN_MAX_MOVEMENTS cruces o PLAN_MAX_PHASES fases, o si no hubo memoria para los despejes.
+ */
+int planFromGroupList(Graph *graph, GroupList *groupList, const double *flows,
+                      PhasePlan *plan) {
+  int numGroups = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    numGroups++;
+  }
+  if (graph->numVertices > PLAN_MAX_MOVEMENTS || numGroups > PLAN_MAX_PHASES) {
+    return -1;
+  }
+
+  memset(plan, 0, sizeof(PhasePlan));
+  plan->numMovements = (uint8_t)graph->numVertices;
+  plan->numPhases = (uint8_t)numGroups;
+
+  int k = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    groupToBitset(graph, g, &plan->phaseMask[k], 1);
+    k++;
+  }
+
+  double *transition = buildTransitionMatrix(graph, groupList, numGroups);
+  if (transition == NULL && numGroups > 0) {
+    return -1;
+  }
+  for (int a = 0; a < numGroups; a++) {
+    for (int b = 0; b < numGroups; b++) {
+      plan->intergreen[a][b] = toTenths(transition[a * numGroups + b]);
+    }
+  }
+  free(transition);
+
+  traceEvent(TRACE_STAGE_BEGIN, STAGE_TIMING, 0);
+  computeTiming(plan, flows);
+  traceEvent(TRACE_STAGE_END, STAGE_TIMING, 0);
+  return 0;
+}
+
+/*
+ * Función: planLostTime
+ * Devuelve el tiempo perdido por despeje en un ciclo del plan, en décimas de segundo.
+ */
+int planLostTime(const PhasePlan *plan) {
+  if (plan->numPhases < 2) {
+    return 0;
+  }
+  int lost = 0;
+  for (int k = 0; k < plan->numPhases; k++) {
+    lost += plan->intergreen[k][(k + 1) % plan->numPhases];
+  }
+  return lost;
+}
+
+/*
+ * Función: computeTiming
+ * Asigna el ciclo y los tiempos de verde del plan con el método de Webster.
+ *
+ * Descripción:
+ * La razón de flujo de cada cruce es su demanda entre SATURATION_FLOW; un cruce que tiene verde en varias fases
+ * reparte su demanda entre ellas. La razón crítica de una fase es la mayor de sus cruces y Y es la suma de las
+ * razones críticas. El ciclo óptimo es (1.5 L + 5) / (1 - Y), acotado entre MIN_CYCLE y MAX_CYCLE, donde L es el
+ * tiempo perdido por despeje. El verde efectivo (ciclo - L) se reparte proporcionalmente a las razones críticas,
+ * con un mínimo de MIN_GREEN por fase. Sin demanda, todas las fases reciben el mismo verde con el ciclo mínimo.
+ *
+ * Parámetros:
+ * - plan: Plan con fases y despejes ya calculados. Se escriben green, cycle y flowRatio.
+ * - flows: Demanda de cada cruce en veh/h, o NULL.
+ *
+ * Retorno: Ninguno.
+ */
+void computeTiming(PhasePlan *plan, const double *flows) {
+  int numPhases = plan->numPhases;
+  if (numPhases == 0) {
+    plan->cycle = 0;
+    plan->flowRatio = 0;
+    return;
+  }
+
+  double critical[PLAN_MAX_PHASES] = {0};
+  double totalRatio = 0;
+  if (flows != NULL) {
+    for (int k = 0; k < numPhases; k++) {
+      for (int i = 0; i < plan->numMovements; i++) {
+        if (!bitsetTest(&plan->phaseMask[k], i)) {
+          continue;
+        }
+        int served = 0;
+        for (int p = 0; p < numPhases; p++) {
+          served += bitsetTest(&plan->phaseMask[p], i);
+        }
+        double ratio = flows[i] / SATURATION_FLOW / served;
+        if (ratio > critical[k]) {
+          critical[k] = ratio;
+        }
+      }
+      totalRatio += critical[k];
+    }
+  }
+
+  double lostTime = planLostTime(plan) / 10.0;
+  double cycle = MIN_CYCLE;
+  if (totalRatio > 0) {
+    cycle = totalRatio < 0.95 ? (1.5 * lostTime + 5) / (1 - totalRatio)
+                              : MAX_CYCLE;
+    if (cycle < MIN_CYCLE) {
+      cycle = MIN_CYCLE;
+    }
+    if (cycle > MAX_CYCLE) {
+      cycle = MAX_CYCLE;
+    }
+  }
+
+  double effectiveGreen = cycle - lostTime;
+  int cycleTenths = planLostTime(plan);
+  for (int k = 0; k < numPhases; k++) {
+    double green = totalRatio > 0 ? effectiveGreen * critical[k] / totalRatio
+                                  : effectiveGreen / numPhases;
+    if (green < MIN_GREEN) {
+      green = MIN_GREEN;
+    }
+    plan->green[k] = toTenths(green);
+    cycleTenths += plan->green[k];
+  }
+  plan->cycle = (uint16_t)(cycleTenths > UINT16_MAX ? UINT16_MAX : cycleTenths);
+  plan->flowRatio = (float)totalRatio;
+}
+
+/*
+ * Función: printPhasePlan
+ * Imprime las fases del plan con sus cruces, verde y despeje hacia la fase siguiente.
+ *
+ * Parámetros:
+ * - graph: Grafo del cruce, usado para los nombres, o NULL para imprimir los índices de los cruces.
+ * - plan: Plan a imprimir.
+ *
+ * Retorno: Ninguno.
+ */
+void printPhasePlan(Graph *graph, const PhasePlan *plan) {
+  printf("Ciclo %.1f s, tiempo perdido %.1f s, Y = %.3f\r\n",
+         plan->cycle / 10.0, planLostTime(plan) / 10.0, plan->flowRatio);
+  for (int k = 0; k < plan->numPhases; k++) {
+    printf(" Fase %d (verde %.1f s, despeje %.1f s):", k + 1,
+           plan->green[k] / 10.0,
+           plan->intergreen[k][(k + 1) % plan->numPhases] / 10.0);
+    for (int i = 0; i < plan->numMovements; i++) {
+      if (!bitsetTest(&plan->phaseMask[k], i)) {
+        continue;
+      }
+      if (graph != NULL) {
+        printf(" %s", graph->adjacencyList[i]->name);
+      } else {
+        printf(" %d", i);
+      }
+    }
+    printf("\r\n");
+  }
+}
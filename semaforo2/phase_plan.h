@@ -0,0 +1,40 @@
+#ifndef PHASE_PLAN_H
+#define PHASE_PLAN_H
+
+#include "graph.h"
+#include "traffic_lights.h"
+#include <stdint.h>
+
+// Límites del plan compacto: un controlador no maneja más de 64 cruces
+// (un bit por cruce en phaseMask) ni más de 16 fases por ciclo
+#define PLAN_MAX_MOVEMENTS 64
+#define PLAN_MAX_PHASES 16
+
+// Parámetros de la temporización de Webster
+#define SATURATION_FLOW 1800.0 // veh/h de verde por cruce
+#define MIN_CYCLE 40.0         // s
+#define MAX_CYCLE 150.0        // s
+#define MIN_GREEN 5.0          // s
+
+// Plan de fases listo para ejecutarse: sin punteros ni cadenas, de modo que
+// puede copiarse, guardarse en tablas o compartirse entre procesos.
+// Todos los tiempos están en décimas de segundo.
+typedef struct PhasePlan {
+  uint8_t numMovements;
+  uint8_t numPhases;
+  uint16_t cycle;
+  uint16_t green[PLAN_MAX_PHASES];
+  uint16_t intergreen[PLAN_MAX_PHASES][PLAN_MAX_PHASES]; // Despeje fase i -> j
+  uint64_t phaseMask[PLAN_MAX_PHASES]; // Cruces con verde, en orden de ciclo
+  float flowRatio;                     // Suma de razones críticas (Y)
+} PhasePlan;
+
+// Funciones a implementar en phase_plan.c
+int buildPhasePlan(Graph *graph, const double *flows, PhasePlan *plan);
+int planFromGroupList(Graph *graph, GroupList *groupList, const double *flows,
+                      PhasePlan *plan);
+void computeTiming(PhasePlan *plan, const double *flows);
+int planLostTime(const PhasePlan *plan);
+void printPhasePlan(Graph *graph, const PhasePlan *plan);
+
+#endif
@@ -0,0 +1,349 @@
+#include "plan_library.h"
+#include "conflicts.h"
+#include "graph.h"
+#include "phase_plan.h"
+#include "sequencing.h"
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Función: readDemandProfiles
+ * Lee los perfiles de demanda de un cruce desde un archivo de texto.
+ *
+ * Descripción:
+ * Cada perfil comienza con una línea `perfil NOMBRE HH:MM` (o `perfil NOMBRE evento` para perfiles sin horario,
+ * como días de evento) seguida de líneas `CRUCE veh/h`. Los cruces no mencionados tienen demanda 0 y las líneas
+ * que comienzan con '#' se ignoran.
+ *
+ * Parámetros:
+ * - filename: Nombre del archivo de perfiles.
+ * - graph: Grafo del cruce, usado para ubicar cada cruce por nombre.
+ * - profileSet: Conjunto donde se guardan los perfiles leídos.
+ *
+ * Retorno:
+ * - 0 si el archivo se leyó correctamente.
+ * - -1 si no se pudo abrir el archivo, no contiene perfiles o no hubo memoria.
+ */
+int readDemandProfiles(char *filename, Graph *graph,
+                       DemandProfileSet *profileSet) {
+  profileSet->numProfiles = 0;
+  FILE *file = fopen(filename, "r");
+  if (file == NULL) {
+    printf("Error: No se pudo abrir el archivo de perfiles.\n");
+    return -1;
+  }
+
+  char line[100];
+  DemandProfile *current = NULL;
+  while (fgets(line, sizeof(line), file)) {
+    char *token = strtok(line, " \t\n");
+    if (token == NULL || token[0] == '#') {
+      continue;
+    }
+
+    if (strcmp(token, "perfil") == 0) {
+      if (profileSet->numProfiles == MAX_PROFILES) {
+        printf("Aviso: Se ignoran los perfiles después del %d.\n",
+               MAX_PROFILES);
+        current = NULL;
+        continue;
+      }
+      current = &profileSet->profiles[profileSet->numProfiles++];
+      char *name = strtok(NULL, " \t\n");
+      char *start = strtok(NULL, " \t\n");
+      snprintf(current->name, PROFILE_NAME_LENGTH, "%s", name ? name : "?");
+      int hours, minutes;
+      if (start != NULL && sscanf(start, "%d:%d", &hours, &minutes) == 2) {
+        current->startMinute = (hours * 60 + minutes) % MINUTES_PER_DAY;
+      } else {
+        current->startMinute = EVENT_PROFILE;
+      }
+      current->flows = (double *)calloc(graph->numVertices, sizeof(double));
+      if (current->flows == NULL) {
+        printf("Error: No se pudo asignar la demanda del perfil en memoria.\n");
+        freeDemandProfiles(profileSet);
+        fclose(file);
+        return -1;
+      }
+      continue;
+    }
+
+    char *value = strtok(NULL, " \t\n");
+    int index = getIndex(graph, token);
+    if (current != NULL && value != NULL && index != -1) {
+      current->flows[index] = atof(value);
+    }
+  }
+
+  fclose(file);
+  if (profileSet->numProfiles == 0) {
+    printf("Error: El archivo de perfiles no contiene perfiles.\n");
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * Función: freeDemandProfiles
+ * Libera la demanda de cada perfil del conjunto.
+ */
+void freeDemandProfiles(DemandProfileSet *profileSet) {
+  for (int p = 0; p < profileSet->numProfiles; p++) {
+    free(profileSet->profiles[p].flows);
+    profileSet->profiles[p].flows = NULL;
+  }
+  profileSet->numProfiles = 0;
+}
+
+/*
+ * Función: buildSchedule
+ * Llena la tabla minuto -> perfil de una intersección.
+ *
+ * Descripción:
+ * En cada minuto rige el perfil con el mayor inicio que no sea posterior a ese minuto; antes del primer inicio del
+ * día sigue vigente el último perfil del día anterior. Los perfiles de evento no entran en el horario. Si no hay
+ * perfiles con horario, rige siempre el perfil 0.
+ */
+static void buildSchedule(DemandProfileSet *profileSet, uint8_t *schedule) {
+  int last = -1; // Perfil con el inicio más tardío
+  for (int p = 0; p < profileSet->numProfiles; p++) {
+    int start = profileSet->profiles[p].startMinute;
+    if (start != EVENT_PROFILE &&
+        (last == -1 || start > profileSet->profiles[last].startMinute)) {
+      last = p;
+    }
+  }
+  if (last == -1) {
+    memset(schedule, 0, MINUTES_PER_DAY);
+    return;
+  }
+
+  int active = last;
+  for (int minute = 0; minute < MINUTES_PER_DAY; minute++) {
+    for (int p = 0; p < profileSet->numProfiles; p++) {
+      if (profileSet->profiles[p].startMinute == minute) {
+        active = p;
+      }
+    }
+    schedule[minute] = (uint8_t)active;
+  }
+}
+
+// Trabajo compartido entre los hilos que construyen la biblioteca
+typedef struct LibraryJobs {
+  PlanLibrary *library;
+  Graph **graphs;
+  DemandProfileSet *profileSets;
+  int numJobs;
+  atomic_int nextJob;
+} LibraryJobs;
+
+/*
+ * Función: libraryWorker
+ * Toma trabajos (intersección, perfil) del contador compartido hasta agotarlos.
+ *
+ * Descripción:
+ * Cada trabajo escribe en una entrada distinta de la tabla, por lo que los hilos no necesitan más sincronización que
+ * el contador atómico.
+ */
+static void *libraryWorker(void *arg) {
+  LibraryJobs *jobs = (LibraryJobs *)arg;
+  int job;
+  while ((job = atomic_fetch_add(&jobs->nextJob, 1)) < jobs->numJobs) {
+    int intersection = job / MAX_PROFILES;
+    int profile = job % MAX_PROFILES;
+    DemandProfileSet *profileSet = &jobs->profileSets[intersection];
+    if (profile >= profileSet->numProfiles) {
+      continue;
+    }
+    int index = intersection * MAX_PROFILES + profile;
+    jobs->library->status[index] =
+        (int8_t)buildPhasePlan(jobs->graphs[intersection],
+                               profileSet->profiles[profile].flows,
+                               &jobs->library->plans[index]);
+  }
+  return NULL;
+}
+
+/*
+ * Función: buildSwitchIntergreens
+ * Calcula el despeje para pasar de la última fase de cada plan a la primera de cada otro plan de la intersección.
+ *
+ * Descripción:
+ * Las fases de dos planes no coinciden, así que el despeje de un cambio de plan no está en la matriz de ninguno de
+ * los dos y se calcula aquí con maskTransition(), que necesita el grafo y su matriz de conflictos.
+ *
+ * Retorno:
+ * - 0 si se calcularon todos los despejes.
+ * - -1 si no se pudo asignar la matriz de conflictos de alguna intersección.
+ */
+static int buildSwitchIntergreens(PlanLibrary *library, Graph **graphs) {
+  for (int i = 0; i < library->numIntersections; i++) {
+    ConflictMatrix *conflicts = buildConflictMatrix(graphs[i]);
+    if (conflicts == NULL) {
+      return -1;
+    }
+    for (int a = 0; a < library->numProfiles[i]; a++) {
+      const PhasePlan *from = getLibraryPlan(library, i, a);
+      if (library->status[i * MAX_PROFILES + a] != 0 || from->numPhases == 0) {
+        continue;
+      }
+      uint64_t last = from->phaseMask[from->numPhases - 1];
+      for (int b = 0; b < library->numProfiles[i]; b++) {
+        const PhasePlan *to = getLibraryPlan(library, i, b);
+        if (library->status[i * MAX_PROFILES + b] != 0 || to->numPhases == 0) {
+          continue;
+        }
+        double seconds =
+            maskTransition(graphs[i], conflicts, last, to->phaseMask[0]);
+        library->switchIntergreen[(i * MAX_PROFILES + a) * MAX_PROFILES + b] =
+            (uint16_t)(seconds * 10 + 0.5);
+      }
+    }
+    freeConflictMatrix(conflicts);
+  }
+  return 0;
+}
+
+/*
+ * Función: buildPlanLibrary
+ * Precalcula en paralelo el plan de cada perfil de demanda de cada intersección.
+ *
+ * Descripción:
+ * Crea la tabla de planes y el horario de cada intersección y reparte los trabajos (intersección, perfil) entre
+ * numThreads hilos. Cada plan pasa por agrupación, traslape, secuencia y temporización con buildPhasePlan().
+ *
+ * Parámetros:
+ * - graphs: Grafo de cada intersección.
+ * - profileSets: Perfiles de demanda de cada intersección.
+ * - numIntersections: Número de intersecciones.
+ * - numThreads: Número de hilos a usar (al menos 1).
+ *
+ * Retorno:
+ * - Puntero a la biblioteca creada, que debe liberarse con freePlanLibrary().
+ * - NULL si no se puede asignar memoria.
+ */
+PlanLibrary *buildPlanLibrary(Graph **graphs, DemandProfileSet *profileSets,
+                              int numIntersections, int numThreads) {
+  PlanLibrary *library = (PlanLibrary *)malloc(sizeof(PlanLibrary));
+  if (library == NULL) {
+    printf("Error: No se pudo asignar la biblioteca de planes en memoria.\n");
+    return NULL;
+  }
+  library->numIntersections = numIntersections;
+  library->numProfiles = (uint8_t *)calloc(numIntersections, sizeof(uint8_t));
+  library->status =
+      (int8_t *)malloc(numIntersections * MAX_PROFILES * sizeof(int8_t));
+  library->schedule =
+      (uint8_t *)malloc(numIntersections * MINUTES_PER_DAY * sizeof(uint8_t));
+  library->plans =
+      (PhasePlan *)calloc(numIntersections * MAX_PROFILES, sizeof(PhasePlan));
+  library->switchIntergreen = (uint16_t *)calloc(
+      numIntersections * MAX_PROFILES * MAX_PROFILES, sizeof(uint16_t));
+  if (library->numProfiles == NULL || library->status == NULL ||
+      library->schedule == NULL || library->plans == NULL ||
+      library->switchIntergreen == NULL) {
+    printf("Error: No se pudo asignar la biblioteca de planes en memoria.\n");
+    freePlanLibrary(library);
+    return NULL;
+  }
+  memset(library->status, PLAN_NOT_BUILT,
+         numIntersections * MAX_PROFILES * sizeof(int8_t));
+
+  for (int i = 0; i < numIntersections; i++) {
+    library->numProfiles[i] = (uint8_t)profileSets[i].numProfiles;
+    buildSchedule(&profileSets[i], &library->schedule[i * MINUTES_PER_DAY]);
+  }
+
+  traceEvent(TRACE_STAGE_BEGIN, STAGE_LIBRARY, 0);
+  LibraryJobs jobs;
+  jobs.library = library;
+  jobs.graphs = graphs;
+  jobs.profileSets = profileSets;
+  jobs.numJobs = numIntersections * MAX_PROFILES;
+  atomic_init(&jobs.nextJob, 0);
+
+  if (numThreads < 1) {
+    numThreads = 1;
+  }
+  pthread_t *threads = (pthread_t *)malloc(numThreads * sizeof(pthread_t));
+  int started = 0;
+  for (int t = 0; t < numThreads; t++) {
+    if (pthread_create(&threads[t], NULL, libraryWorker, &jobs) == 0) {
+      started++;
+    } else {
+      break;
+    }
+  }
+  if (started == 0) {
+    libraryWorker(&jobs); // Sin hilos disponibles se construye aquí mismo
+  }
+  for (int t = 0; t < started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  free(threads);
+  int switched = buildSwitchIntergreens(library, graphs);
+  traceEvent(TRACE_STAGE_END, STAGE_LIBRARY, 0);
+  if (switched != 0) {
+    printf("Error: No se pudo asignar la biblioteca de planes en memoria.\n");
+    freePlanLibrary(library);
+    return NULL;
+  }
+
+  return library;
+}
+
+/*
+ * Función: freePlanLibrary
+ * Libera la memoria de la biblioteca de planes.
+ */
+void freePlanLibrary(PlanLibrary *library) {
+  if (library) {
+    free(library->numProfiles);
+    free(library->status);
+    free(library->schedule);
+    free(library->plans);
+    free(library->switchIntergreen);
+    free(library);
+  }
+}
+
+/*
+ * Función: printPlanLibrary
+ * Imprime el plan de cada perfil de cada intersección.
+ *
+ * Parámetros:
+ * - library: Biblioteca a imprimir.
+ * - graphs: Grafo de cada intersección, para los nombres de los cruces.
+ * - profileSets: Perfiles de cada intersección, para los nombres y horarios.
+ *
+ * Retorno: Ninguno.
+ */
+void printPlanLibrary(PlanLibrary *library, Graph **graphs,
+                      DemandProfileSet *profileSets) {
+  for (int i = 0; i < library->numIntersections; i++) {
+    printf("Interseccion %d:\n", i);
+    for (int p = 0; p < library->numProfiles[i]; p++) {
+      DemandProfile *profile = &profileSets[i].profiles[p];
+      if (profile->startMinute == EVENT_PROFILE) {
+        printf("Perfil %s (evento): ", profile->name);
+      } else {
+        printf("Perfil %s (desde %02d:%02d): ", profile->name,
+               profile->startMinute / 60, profile->startMinute % 60);
+      }
+      if (library->status[i * MAX_PROFILES + p] != 0) {
+        printf("Error: el plan excede %d cruces o %d fases, o junta cruces "
+               "incompatibles.\n",
+               PLAN_MAX_MOVEMENTS, PLAN_MAX_PHASES);
+        continue;
+      }
+      printPhasePlan(graphs[i], getLibraryPlan(library, i, p));
+    }
+    printf("\n");
+  }
+}
@@ -0,0 +1,73 @@
+#ifndef PLAN_LIBRARY_H
+#define PLAN_LIBRARY_H
+
+#include "graph.h"
+#include "phase_plan.h"
+#include <stdint.h>
+
+#define MAX_PROFILES 8
+#define PROFILE_NAME_LENGTH 8
+#define MINUTES_PER_DAY 1440
+#define EVENT_PROFILE -1 // Perfil sin horario, solo se elige explícitamente
+
+// Demanda de un cruce en un periodo del día (veh/h por cruce)
+typedef struct DemandProfile {
+  char name[PROFILE_NAME_LENGTH];
+  int startMinute; // Minuto del día en que empieza, o EVENT_PROFILE
+  double *flows;   // numVertices valores
+} DemandProfile;
+
+typedef struct DemandProfileSet {
+  int numProfiles;
+  DemandProfile profiles[MAX_PROFILES];
+} DemandProfileSet;
+
+// Tabla de planes precalculados. Los planes de la intersección i están en
+// plans[i * MAX_PROFILES + p] y schedule[i * MINUTES_PER_DAY + m] es el perfil
+// vigente en el minuto m, de modo que cambiar de plan es un acceso a la tabla.
+// switchIntergreen[(i * MAX_PROFILES + a) * MAX_PROFILES + b] es el despeje
+// (décimas de segundo) de la última fase del plan a a la primera del plan b:
+// el cambio de plan ocurre al terminar el verde de la última fase del plan a,
+// y este despeje reemplaza al que cerraría su ciclo.
+#define PLAN_NOT_BUILT 1 // status de un plan que aún no se construye
+
+typedef struct PlanLibrary {
+  int numIntersections;
+  uint8_t *numProfiles;
+  int8_t *status; // 0 si se construyó, -1 si no es válido, PLAN_NOT_BUILT
+  uint8_t *schedule;
+  PhasePlan *plans;
+  uint16_t *switchIntergreen;
+} PlanLibrary;
+
+static inline const PhasePlan *getLibraryPlan(const PlanLibrary *library,
+                                              int intersection, int profile) {
+  return &library->plans[intersection * MAX_PROFILES + profile];
+}
+
+static inline uint16_t getSwitchIntergreen(const PlanLibrary *library,
+                                           int intersection, int from,
+                                           int to) {
+  return library->switchIntergreen[(intersection * MAX_PROFILES + from) *
+                                       MAX_PROFILES +
+                                   to];
+}
+
+static inline const PhasePlan *selectPlan(const PlanLibrary *library,
+                                          int intersection, int minute) {
+  return getLibraryPlan(
+      library, intersection,
+      library->schedule[intersection * MINUTES_PER_DAY + minute]);
+}
+
+// Funciones a implementar en plan_library.c
+int readDemandProfiles(char *filename, Graph *graph,
+                       DemandProfileSet *profileSet);
+void freeDemandProfiles(DemandProfileSet *profileSet);
+PlanLibrary *buildPlanLibrary(Graph **graphs, DemandProfileSet *profileSets,
+                              int numIntersections, int numThreads);
+void freePlanLibrary(PlanLibrary *library);
+void printPlanLibrary(PlanLibrary *library, Graph **graphs,
+                      DemandProfileSet *profileSets);
+
+#endif
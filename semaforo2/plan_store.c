@@ -0,0 +1,284 @@
+#include "plan_store.h"
+#include "phase_plan.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Los contadores se comparten entre procesos, así que no pueden depender de
+// un candado interno de la biblioteca de atómicos
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2,
+               "El almacen de planes requiere enteros atomicos sin candados");
+
+/*
+ * Función: hashIntersection
+ * Mezcla los bits del identificador de una intersección para elegir su primera entrada.
+ */
+static unsigned hashIntersection(int intersection) {
+  uint32_t h = (uint32_t)intersection;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h & (PLAN_STORE_SLOTS - 1);
+}
+
+/*
+ * Función: findSlot
+ * Busca la entrada de una intersección con sondeo lineal.
+ *
+ * Retorno:
+ * - Índice de la entrada de la intersección.
+ * - Si no existe, el índice de la primera entrada libre encontrada, o -1 si el almacén está lleno. `found` indica
+ *   cuál de los dos casos ocurrió.
+ */
+static int findSlot(const PlanStore *store, int intersection, bool *found) {
+  int key = intersection + 1;
+  unsigned start = hashIntersection(intersection);
+  for (unsigned probe = 0; probe < PLAN_STORE_SLOTS; probe++) {
+    unsigned index = (start + probe) & (PLAN_STORE_SLOTS - 1);
+    int slotKey =
+        atomic_load_explicit(&store->slots[index].key, memory_order_acquire);
+    if (slotKey == key || slotKey == PLAN_STORE_EMPTY) {
+      *found = slotKey == key;
+      return (int)index;
+    }
+  }
+  *found = false;
+  return -1;
+}
+
+/*
+ * Función: createPlanStore
+ * Crea (o reabre) el segmento compartido del planificador.
+ *
+ * Descripción:
+ * Si el segmento ya existe con la misma disposición se conservan los planes y contadores publicados, de modo que
+ * reiniciar el planificador no confunde a los lectores conectados; si no, se inicializa vacío.
+ *
+ * Parámetros:
+ * - name: Nombre POSIX del segmento (por ejemplo PLAN_STORE_NAME).
+ *
+ * Retorno:
+ * - Puntero al almacén, que debe cerrarse con closePlanStore().
+ * - NULL si no se pudo crear o proyectar el segmento.
+ */
+PlanStore *createPlanStore(const char *name) {
+  int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+  if (fd == -1) {
+    printf("Error: No se pudo crear el segmento compartido %s.\n", name);
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1 ||
+      ((size_t)info.st_size != sizeof(PlanStore) &&
+       ftruncate(fd, sizeof(PlanStore)) == -1)) {
+    printf("Error: No se pudo ajustar el tamaño del segmento compartido.\n");
+    close(fd);
+    return NULL;
+  }
+  PlanStore *store = (PlanStore *)mmap(NULL, sizeof(PlanStore),
+                                       PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (store == MAP_FAILED) {
+    printf("Error: No se pudo proyectar el segmento compartido en memoria.\n");
+    return NULL;
+  }
+
+  if (store->magic != PLAN_STORE_MAGIC ||
+      store->version != PLAN_STORE_VERSION ||
+      store->numSlots != PLAN_STORE_SLOTS ||
+      store->slotSize != sizeof(PlanSlot) ||
+      store->planSize != sizeof(PhasePlan)) {
+    memset(store, 0, sizeof(PlanStore));
+    store->version = PLAN_STORE_VERSION;
+    store->numSlots = PLAN_STORE_SLOTS;
+    store->slotSize = sizeof(PlanSlot);
+    store->planSize = sizeof(PhasePlan);
+    atomic_thread_fence(memory_order_release);
+    store->magic = PLAN_STORE_MAGIC;
+  }
+  return store;
+}
+
+/*
+ * Función: publishPlan
+ * Publica el plan de una intersección.
+ *
+ * Descripción:
+ * Escribe el plan en la copia que los lectores no están usando y luego avanza el contador de secuencia, que es lo
+ * único que los lectores observan. Una intersección nueva solo se vuelve visible (su key) después de publicar su
+ * primer plan. Solo un proceso debe publicar en el almacén.
+ *
+ * Parámetros:
+ * - store: Almacén abierto con createPlanStore().
+ * - intersection: Identificador de la intersección (no negativo).
+ * - plan: Plan a publicar.
+ *
+ * Retorno:
+ * - 0 si el plan se publicó.
+ * - -1 si el identificador no es válido o el almacén está lleno.
+ */
+int publishPlan(PlanStore *store, int intersection, const PhasePlan *plan) {
+  bool found;
+  int index = intersection < 0 ? -1 : findSlot(store, intersection, &found);
+  if (index == -1) {
+    printf("Error: No se pudo publicar el plan de la interseccion %d.\n",
+           intersection);
+    return -1;
+  }
+
+  PlanSlot *slot = &store->slots[index];
+  unsigned sequence =
+      atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+  unsigned version = (sequence >> 1) + 1;
+  atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+  memcpy(&slot->plans[version & 1], plan, sizeof(PhasePlan));
+  atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+
+  if (!found) {
+    atomic_store_explicit(&slot->key, intersection + 1, memory_order_release);
+    atomic_fetch_add_explicit(&store->numPlans, 1, memory_order_relaxed);
+  }
+  return 0;
+}
+
+/*
+ * Función: closePlanStore
+ * Desconecta al escritor del segmento. El segmento y sus planes siguen disponibles para los lectores.
+ */
+void closePlanStore(PlanStore *store) {
+  if (store) {
+    munmap(store, sizeof(PlanStore));
+  }
+}
+
+/*
+ * Función: removePlanStore
+ * Elimina el segmento compartido; los procesos conectados conservan su proyección hasta desconectarse.
+ */
+int removePlanStore(const char *name) { return shm_unlink(name); }
+
+/*
+ * Función: attachPlanStore
+ * Conecta un lector al segmento compartido, en modo de solo lectura.
+ *
+ * Parámetros:
+ * - name: Nombre POSIX del segmento.
+ *
+ * Retorno:
+ * - Puntero al almacén, que debe liberarse con detachPlanStore().
+ * - NULL si el segmento no existe o fue creado con una disposición distinta.
+ */
+const PlanStore *attachPlanStore(const char *name) {
+  int fd = shm_open(name, O_RDONLY, 0);
+  if (fd == -1) {
+    printf("Error: No se pudo abrir el segmento compartido %s.\n", name);
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1 || (size_t)info.st_size != sizeof(PlanStore)) {
+    printf("Error: El segmento compartido no tiene el tamaño esperado.\n");
+    close(fd);
+    return NULL;
+  }
+  const PlanStore *store = (const PlanStore *)mmap(
+      NULL, sizeof(PlanStore), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (store == MAP_FAILED) {
+    printf("Error: No se pudo proyectar el segmento compartido en memoria.\n");
+    return NULL;
+  }
+
+  if (store->magic != PLAN_STORE_MAGIC ||
+      store->version != PLAN_STORE_VERSION ||
+      store->numSlots != PLAN_STORE_SLOTS ||
+      store->slotSize != sizeof(PlanSlot) ||
+      store->planSize != sizeof(PhasePlan)) {
+    printf("Error: El segmento compartido tiene una version incompatible.\n");
+    munmap((void *)store, sizeof(PlanStore));
+    return NULL;
+  }
+  return store;
+}
+
+/*
+ * Función: detachPlanStore
+ * Desconecta a un lector del segmento compartido.
+ */
+void detachPlanStore(const PlanStore *store) {
+  if (store) {
+    munmap((void *)store, sizeof(PlanStore));
+  }
+}
+
+/*
+ * Función: beginPlanRead
+ * Comienza una lectura sin copia del plan de una intersección.
+ *
+ * Descripción:
+ * Devuelve un puntero a la copia estable del plan dentro del segmento. El plan puede usarse directamente, pero
+ * cualquier resultado obtenido de él solo es válido si después validatePlanRead() devuelve true; si no, hay que
+ * repetir la lectura.
+ *
+ * Parámetros:
+ * - store: Almacén conectado.
+ * - intersection: Identificador de la intersección.
+ * - ticket: Donde se guarda el estado necesario para validar la lectura.
+ *
+ * Retorno:
+ * - Puntero al plan publicado.
+ * - NULL si la intersección no tiene plan publicado.
+ */
+const PhasePlan *beginPlanRead(const PlanStore *store, int intersection,
+                               PlanReadTicket *ticket) {
+  bool found;
+  int index = intersection < 0 ? -1 : findSlot(store, intersection, &found);
+  if (index == -1 || !found) {
+    return NULL;
+  }
+  ticket->slot = &store->slots[index];
+  ticket->sequence =
+      atomic_load_explicit(&ticket->slot->sequence, memory_order_acquire);
+  return &ticket->slot->plans[(ticket->sequence >> 1) & 1];
+}
+
+/*
+ * Función: validatePlanRead
+ * Indica si el plan leído desde beginPlanRead() no fue modificado durante la lectura.
+ *
+ * Descripción:
+ * La copia leída solo se sobrescribe al comenzar la segunda publicación posterior a beginPlanRead(), es decir,
+ * cuando el contador avanza más de 2 desde la última versión estable.
+ */
+bool validatePlanRead(const PlanReadTicket *ticket) {
+  atomic_thread_fence(memory_order_acquire);
+  unsigned sequence =
+      atomic_load_explicit(&ticket->slot->sequence, memory_order_relaxed);
+  return sequence - (ticket->sequence & ~1u) <= 2;
+}
+
+/*
+ * Función: readPlan
+ * Copia el plan de una intersección, reintentando hasta obtener una copia consistente.
+ *
+ * Retorno:
+ * - 0 si se copió el plan.
+ * - -1 si la intersección no tiene plan publicado.
+ */
+int readPlan(const PlanStore *store, int intersection, PhasePlan *plan) {
+  PlanReadTicket ticket;
+  do {
+    const PhasePlan *shared = beginPlanRead(store, intersection, &ticket);
+    if (shared == NULL) {
+      return -1;
+    }
+    memcpy(plan, shared, sizeof(PhasePlan));
+  } while (!validatePlanRead(&ticket));
+  return 0;
+}
@@ -0,0 +1,63 @@
+#ifndef PLAN_STORE_H
+#define PLAN_STORE_H
+
+#include "phase_plan.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Segmento de memoria compartida POSIX donde el planificador publica el plan
+// vigente de cada intersección para que otros procesos (controlador, bitácora,
+// tablero) lo lean sin volver a leer el grafo ni planificar.
+#define PLAN_STORE_NAME "/semaforo_planes"
+#define PLAN_STORE_MAGIC 0x4e4c5053 // "SPLN"
+#define PLAN_STORE_VERSION 1
+#define PLAN_STORE_SLOTS 1024 // Potencia de 2
+#define PLAN_STORE_EMPTY 0    // key de una entrada libre
+
+// Entrada de una intersección. Cada entrada tiene dos copias del plan y un
+// contador de secuencia: la versión publicada es sequence / 2 y está en
+// plans[(sequence / 2) % 2]; un valor impar indica que el escritor está
+// llenando la otra copia. Así un lector siempre tiene una copia estable y solo
+// debe reintentar si se publicaron dos versiones mientras leía.
+typedef struct PlanSlot {
+  _Alignas(64) atomic_uint sequence;
+  atomic_int key; // Intersección + 1, o PLAN_STORE_EMPTY
+  PhasePlan plans[2];
+} PlanSlot;
+
+// Disposición fija del segmento. Los tamaños en la cabecera permiten a un
+// lector rechazar un segmento creado por una versión incompatible.
+typedef struct PlanStore {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numSlots;
+  uint32_t slotSize;
+  uint32_t planSize;
+  atomic_uint numPlans;
+  PlanSlot slots[PLAN_STORE_SLOTS];
+} PlanStore;
+
+// Lectura sin copia en curso: se obtiene con beginPlanRead() y se confirma
+// con validatePlanRead() después de usar el plan.
+typedef struct PlanReadTicket {
+  const PlanSlot *slot;
+  unsigned sequence;
+} PlanReadTicket;
+
+// Funciones a implementar en plan_store.c
+// Escritor (un solo proceso)
+PlanStore *createPlanStore(const char *name);
+int publishPlan(PlanStore *store, int intersection, const PhasePlan *plan);
+void closePlanStore(PlanStore *store);
+int removePlanStore(const char *name);
+
+// Lectores
+const PlanStore *attachPlanStore(const char *name);
+void detachPlanStore(const PlanStore *store);
+const PhasePlan *beginPlanRead(const PlanStore *store, int intersection,
+                               PlanReadTicket *ticket);
+bool validatePlanRead(const PlanReadTicket *ticket);
+int readPlan(const PlanStore *store, int intersection, PhasePlan *plan);
+
+#endif
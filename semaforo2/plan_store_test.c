@@ -0,0 +1,240 @@
+#include "plan_store.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Prueba del almacén de planes en memoria compartida: ida y vuelta entre
+// escritor y lector, reintento de validatePlanRead() cuando el escritor
+// publica dos veces durante una lectura, un lector en otro proceso que nunca
+// debe aceptar una copia a medio escribir, y reapertura de un segmento con
+// otra disposición. Se usa con `make test`.
+#define TEST_INTERSECTIONS 64
+#define TEST_PUBLICATIONS 200000
+
+static int errors = 0;
+
+static void check(bool condition, const char *message) {
+  if (!condition) {
+    printf("Error: %s\n", message);
+    errors++;
+  }
+}
+
+/*
+ * Función: fillPlan
+ * Llena un plan con un valor que identifica la publicación en todos sus campos, para detectar copias mezcladas.
+ */
+static void fillPlan(PhasePlan *plan, uint16_t value) {
+  memset(plan, 0, sizeof(PhasePlan));
+  plan->numMovements = 10;
+  plan->numPhases = PLAN_MAX_PHASES;
+  plan->cycle = value;
+  for (int k = 0; k < PLAN_MAX_PHASES; k++) {
+    plan->green[k] = value;
+    plan->phaseMask[k] = value;
+    for (int j = 0; j < PLAN_MAX_PHASES; j++) {
+      plan->intergreen[k][j] = value;
+    }
+  }
+}
+
+/*
+ * Función: isConsistent
+ * Indica si todos los campos del plan tienen el valor de una misma publicación.
+ */
+static bool isConsistent(const PhasePlan *plan) {
+  for (int k = 0; k < PLAN_MAX_PHASES; k++) {
+    if (plan->green[k] != plan->cycle || plan->phaseMask[k] != plan->cycle ||
+        plan->intergreen[k][PLAN_MAX_PHASES - 1] != plan->cycle) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Función: testRoundTrip
+ * Publica un plan por intersección y comprueba que un lector los lee iguales.
+ */
+static void testRoundTrip(const char *name) {
+  PlanStore *store = createPlanStore(name);
+  const PlanStore *reader = attachPlanStore(name);
+  check(store != NULL && reader != NULL, "no se pudo abrir el almacen");
+  if (store == NULL || reader == NULL) {
+    closePlanStore(store);
+    detachPlanStore(reader);
+    return;
+  }
+
+  PhasePlan plan, copy;
+  for (int i = 0; i < TEST_INTERSECTIONS; i++) {
+    fillPlan(&plan, (uint16_t)(i * 7 + 1));
+    check(publishPlan(store, i, &plan) == 0, "no se pudo publicar un plan");
+  }
+  check(atomic_load(&reader->numPlans) == TEST_INTERSECTIONS,
+        "el numero de planes publicados no coincide");
+  for (int i = 0; i < TEST_INTERSECTIONS; i++) {
+    fillPlan(&plan, (uint16_t)(i * 7 + 1));
+    check(readPlan(reader, i, &copy) == 0 &&
+              memcmp(&plan, &copy, sizeof(PhasePlan)) == 0,
+          "el plan leido no es el publicado");
+  }
+  check(readPlan(reader, TEST_INTERSECTIONS, &copy) == -1,
+        "se leyo un plan que no se publico");
+
+  // Republicar no agrega intersecciones
+  fillPlan(&plan, 999);
+  publishPlan(store, 0, &plan);
+  check(readPlan(reader, 0, &copy) == 0 && copy.cycle == 999,
+        "no se leyo la ultima version del plan");
+  check(atomic_load(&reader->numPlans) == TEST_INTERSECTIONS,
+        "republicar cambio el numero de planes");
+
+  detachPlanStore(reader);
+  closePlanStore(store);
+}
+
+/*
+ * Función: testRetry
+ * Comprueba que una lectura sigue siendo válida tras una publicación y deja de serlo tras la segunda.
+ */
+static void testRetry(const char *name) {
+  PlanStore *store = createPlanStore(name);
+  if (store == NULL) {
+    errors++;
+    return;
+  }
+  PhasePlan plan;
+  fillPlan(&plan, 1);
+  publishPlan(store, 5, &plan);
+
+  PlanReadTicket ticket;
+  const PhasePlan *shared = beginPlanRead(store, 5, &ticket);
+  check(shared != NULL && shared->cycle == 1, "no se pudo comenzar la lectura");
+  fillPlan(&plan, 2);
+  publishPlan(store, 5, &plan);
+  check(validatePlanRead(&ticket) && shared->cycle == 1,
+        "una publicacion invalido una lectura de la otra copia");
+  fillPlan(&plan, 3);
+  publishPlan(store, 5, &plan);
+  check(!validatePlanRead(&ticket),
+        "dos publicaciones no invalidaron la lectura");
+
+  shared = beginPlanRead(store, 5, &ticket);
+  check(shared != NULL && shared->cycle == 3 && validatePlanRead(&ticket),
+        "el reintento no leyo la ultima version");
+  closePlanStore(store);
+}
+
+/*
+ * Función: testConcurrentReader
+ * Un lector en otro proceso lee sin parar mientras el escritor publica; no debe aceptar ninguna copia mezclada.
+ */
+static void testConcurrentReader(const char *name) {
+  PlanStore *store = createPlanStore(name);
+  if (store == NULL) {
+    errors++;
+    return;
+  }
+  PhasePlan plan;
+  fillPlan(&plan, 1);
+  publishPlan(store, 7, &plan);
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    const PlanStore *reader = attachPlanStore(name);
+    if (reader == NULL) {
+      _exit(1);
+    }
+    int torn = 0;
+    PhasePlan copy;
+    uint16_t last = 0;
+    while (last != (uint16_t)TEST_PUBLICATIONS) {
+      if (readPlan(reader, 7, &copy) != 0 || !isConsistent(&copy)) {
+        torn++;
+        break;
+      }
+      last = copy.cycle;
+    }
+    detachPlanStore(reader);
+    _exit(torn == 0 ? 0 : 2);
+  }
+  check(pid > 0, "no se pudo crear el proceso lector");
+
+  for (int v = 2; v <= TEST_PUBLICATIONS; v++) {
+    fillPlan(&plan, (uint16_t)v);
+    publishPlan(store, 7, &plan);
+  }
+  int status = 1;
+  if (pid > 0) {
+    waitpid(pid, &status, 0);
+  }
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 0,
+        "el lector acepto una copia a medio escribir");
+  closePlanStore(store);
+}
+
+/*
+ * Función: testLayout
+ * Un segmento con otra disposición lo rechaza el lector y el escritor lo reinicia vacío.
+ */
+static void testLayout(const char *name) {
+  PlanStore *store = createPlanStore(name);
+  if (store == NULL) {
+    errors++;
+    return;
+  }
+  PhasePlan plan;
+  fillPlan(&plan, 1);
+  publishPlan(store, 3, &plan);
+  store->slotSize += 64; // Como si lo hubiera creado otra versión
+  closePlanStore(store);
+
+  printf("(se esperan los avisos de version incompatible y de tamano)\n");
+  check(attachPlanStore(name) == NULL,
+        "el lector acepto un segmento de otra disposicion");
+  store = createPlanStore(name);
+  const PlanStore *reader = attachPlanStore(name);
+  PhasePlan copy;
+  check(store != NULL && reader != NULL &&
+            atomic_load(&reader->numPlans) == 0 &&
+            readPlan(reader, 3, &copy) == -1,
+        "el escritor no reinicio el segmento de otra disposicion");
+  detachPlanStore(reader);
+  closePlanStore(store);
+
+  // Un segmento de otro tamaño
+  int fd = shm_open(name, O_RDWR, 0);
+  check(fd != -1 && ftruncate(fd, sizeof(PlanStore) / 2) == 0,
+        "no se pudo cambiar el tamano del segmento");
+  if (fd != -1) {
+    close(fd);
+  }
+  check(attachPlanStore(name) == NULL,
+        "el lector acepto un segmento de otro tamano");
+  store = createPlanStore(name);
+  reader = attachPlanStore(name);
+  check(store != NULL && reader != NULL, "el escritor no ajusto el tamano");
+  detachPlanStore(reader);
+  closePlanStore(store);
+}
+
+int main(void) {
+  char name[64];
+  snprintf(name, sizeof(name), "/semaforo_planes_prueba_%d", (int)getpid());
+  removePlanStore(name);
+
+  testRoundTrip(name);
+  testRetry(name);
+  testConcurrentReader(name);
+  testLayout(name);
+
+  removePlanStore(name);
+  printf("plan_store_test: %d errores\n", errors);
+  return errors == 0 ? 0 : 1;
+}
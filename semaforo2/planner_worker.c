@@ -0,0 +1,93 @@
+#include "planner_worker.h"
+#include "graph.h"
+#include "trace.h"
+#include "traffic_lights.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/*
+ * Función: planningThread
+ * Cuerpo del hilo de fondo: planifica las fases y avisa por el eventfd.
+ */
+static void *planningThread(void *arg) {
+  PlanningJob *job = (PlanningJob *)arg;
+  job->completed =
+      planGroups(job->graph, job->graph->flow, &job->groupList, &job->lostTime,
+                 &job->progress);
+
+  uint64_t one = 1;
+  if (write(job->eventFd, &one, sizeof(one)) != sizeof(one)) {
+    perror("eventfd");
+  }
+  return NULL;
+}
+
+/*
+ * Función: startPlanning
+ * Inicia la planificación de fases del grafo en un hilo de fondo.
+ *
+ * Parámetros:
+ * - job: Trabajo a iniciar; no debe estar en curso.
+ * - graph: Grafo a planificar. No debe modificarse hasta llamar a finishPlanning().
+ *
+ * Retorno:
+ * - 0 si el hilo se inició.
+ * - -1 si no se pudo crear el eventfd o el hilo.
+ */
+int startPlanning(PlanningJob *job, Graph *graph) {
+  job->graph = graph;
+  job->groupList.head = NULL;
+  job->groupList.tail = NULL;
+  job->lostTime = 0;
+  job->completed = false;
+  atomic_init(&job->progress.stage, STAGE_GROUPING);
+  atomic_init(&job->progress.verticesAssigned, 0);
+  atomic_init(&job->progress.phases, 0);
+  atomic_init(&job->progress.cancelled, false);
+
+  job->eventFd = eventfd(0, EFD_CLOEXEC);
+  if (job->eventFd == -1) {
+    return -1;
+  }
+  if (pthread_create(&job->thread, NULL, planningThread, job) != 0) {
+    close(job->eventFd);
+    return -1;
+  }
+  job->running = true;
+  return 0;
+}
+
+/*
+ * Función: cancelPlanning
+ * Pide al hilo de fondo que se detenga; la planificación revisa la petición en cada vértice, grupo o pasada.
+ */
+void cancelPlanning(PlanningJob *job) {
+  atomic_store(&job->progress.cancelled, true);
+}
+
+/*
+ * Función: finishPlanning
+ * Espera al hilo de fondo y libera el eventfd.
+ *
+ * Descripción:
+ * Debe llamarse una vez que el eventfd está listo para leerse, o después de cancelPlanning(); en ambos casos el
+ * hilo ya terminó o está por terminar, así que la espera es breve.
+ *
+ * Retorno:
+ * - true si la planificación terminó y job->groupList contiene el resultado (que debe liberarse con
+ *   freeGroupList()).
+ * - false si fue cancelada.
+ */
+bool finishPlanning(PlanningJob *job) {
+  if (!job->running) {
+    return false;
+  }
+  pthread_join(job->thread, NULL);
+  close(job->eventFd);
+  job->eventFd = -1;
+  job->running = false;
+  return job->completed;
+}
@@ -0,0 +1,28 @@
+#ifndef PLANNER_WORKER_H
+#define PLANNER_WORKER_H
+
+#include "graph.h"
+#include "traffic_lights.h"
+#include <pthread.h>
+#include <stdbool.h>
+
+// Planificación de fases en un hilo de fondo. Al terminar (o al detenerse
+// por cancelación) el hilo escribe en `eventFd`, que la interfaz espera con
+// poll() junto a la entrada estándar.
+typedef struct PlanningJob {
+  Graph *graph;
+  PlanningProgress progress;
+  GroupList groupList;
+  double lostTime;
+  bool completed;
+  bool running;
+  int eventFd;
+  pthread_t thread;
+} PlanningJob;
+
+// Funciones a implementar en planner_worker.c
+int startPlanning(PlanningJob *job, Graph *graph);
+void cancelPlanning(PlanningJob *job);
+bool finishPlanning(PlanningJob *job);
+
+#endif
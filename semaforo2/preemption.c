@@ -0,0 +1,71 @@
+#include "preemption.h"
+#include "bitset.h"
+#include "phase_plan.h"
+
+#include <string.h>
+
+/*
+ * Función: buildPreemptionTable
+ * Precalcula el camino de despeje mínimo desde cada fase hacia el verde de cada cruce.
+ *
+ * Descripción:
+ * Para dar paso a un vehículo de emergencia la fase actual se corta de inmediato, así que el costo de saltar de la
+ * fase p a la fase q es su despeje intergreen[p][q]. Puede convenir pasar por una fase intermedia r si sus
+ * despejes son menores; en ese caso r debe mantener al menos MIN_GREEN de verde. Las distancias mínimas entre todas
+ * las parejas de fases se calculan con Floyd-Warshall, guardando la siguiente fase de cada camino. Luego, para cada
+ * fase y cada cruce, se elige la fase de destino más cercana que le da verde. Debe volver a llamarse cada vez que
+ * cambia el plan.
+ *
+ * Parámetros:
+ * - plan: Plan de fases.
+ * - table: Tabla donde se escribe el resultado.
+ *
+ * Retorno: Ninguno.
+ */
+void buildPreemptionTable(const PhasePlan *plan, PreemptionTable *table) {
+  int numPhases = plan->numPhases;
+  int minGreen = (int)(MIN_GREEN * 10);
+  int distance[PLAN_MAX_PHASES][PLAN_MAX_PHASES];
+
+  memset(table, 0, sizeof(PreemptionTable));
+  for (int p = 0; p < numPhases; p++) {
+    for (int q = 0; q < numPhases; q++) {
+      distance[p][q] = p == q ? 0 : plan->intergreen[p][q];
+      table->nextHop[p][q] = (uint8_t)q;
+    }
+  }
+
+  for (int r = 0; r < numPhases; r++) {
+    for (int p = 0; p < numPhases; p++) {
+      for (int q = 0; q < numPhases; q++) {
+        if (p == q || p == r || q == r) {
+          continue;
+        }
+        int viaR = distance[p][r] + minGreen + distance[r][q];
+        if (viaR < distance[p][q]) {
+          distance[p][q] = viaR;
+          table->nextHop[p][q] = table->nextHop[p][r];
+        }
+      }
+    }
+  }
+
+  for (int p = 0; p < numPhases; p++) {
+    for (int m = 0; m < PLAN_MAX_MOVEMENTS; m++) {
+      PreemptionEntry *entry = &table->entries[p][m];
+      entry->targetPhase = PREEMPTION_NONE;
+      entry->nextPhase = PREEMPTION_NONE;
+      entry->time = UINT16_MAX;
+      if (m >= plan->numMovements) {
+        continue;
+      }
+      for (int q = 0; q < numPhases; q++) {
+        if (bitsetTest(&plan->phaseMask[q], m) && distance[p][q] < entry->time) {
+          entry->targetPhase = (uint8_t)q;
+          entry->nextPhase = table->nextHop[p][q];
+          entry->time = (uint16_t)distance[p][q];
+        }
+      }
+    }
+  }
+}
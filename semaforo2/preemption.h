@@ -0,0 +1,31 @@
+#ifndef PREEMPTION_H
+#define PREEMPTION_H
+
+#include "phase_plan.h"
+#include <stdint.h>
+
+#define PREEMPTION_NONE 0xFF // Ninguna fase del plan sirve al cruce
+
+// Camino más rápido desde una fase hacia el verde de un cruce
+typedef struct PreemptionEntry {
+  uint8_t targetPhase; // Fase que da verde al cruce
+  uint8_t nextPhase;   // Siguiente fase del camino (la fase actual si ya sirve)
+  uint16_t time;       // Décimas de segundo hasta el inicio del verde
+} PreemptionEntry;
+
+// Tabla precalculada para todas las parejas (fase actual, cruce objetivo).
+// nextHop[p][q] es la fase que sigue a p en el camino más rápido hacia q.
+typedef struct PreemptionTable {
+  PreemptionEntry entries[PLAN_MAX_PHASES][PLAN_MAX_MOVEMENTS];
+  uint8_t nextHop[PLAN_MAX_PHASES][PLAN_MAX_PHASES];
+} PreemptionTable;
+
+static inline const PreemptionEntry *
+preemptionLookup(const PreemptionTable *table, int phase, int movement) {
+  return &table->entries[phase][movement];
+}
+
+// Funciones a implementar en preemption.c
+void buildPreemptionTable(const PhasePlan *plan, PreemptionTable *table);
+
+#endif
@@ -0,0 +1,289 @@
+#include "recording.h"
+#include "phase_plan.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MS_PER_HOUR 3600000.0
+#define MS_PER_MINUTE 60000
+
+/*
+ * Función: openRecording
+ * Crea un archivo de grabación vacío para escribir detecciones.
+ *
+ * Parámetros:
+ * - filename: Archivo de salida.
+ * - numMovements: Vértices del grafo de la intersección (a lo más PLAN_MAX_MOVEMENTS).
+ * - startMs: Hora del día en que empieza la grabación, en ms desde medianoche.
+ *
+ * Retorno:
+ * - Puntero al escritor, que debe cerrarse con closeRecording().
+ * - NULL si el archivo no se pudo crear.
+ */
+RecordingWriter *openRecording(const char *filename, int numMovements,
+                               uint64_t startMs) {
+  if (numMovements < 1 || numMovements > PLAN_MAX_MOVEMENTS) {
+    printf("Error: La grabacion admite de 1 a %d cruces.\n",
+           PLAN_MAX_MOVEMENTS);
+    return NULL;
+  }
+  RecordingWriter *writer = (RecordingWriter *)calloc(1, sizeof(RecordingWriter));
+  if (writer == NULL) {
+    printf("Error: No se pudo asignar la grabacion en memoria.\n");
+    return NULL;
+  }
+  writer->file = fopen(filename, "wb");
+  if (writer->file == NULL) {
+    printf("Error: No se pudo crear el archivo %s.\n", filename);
+    free(writer);
+    return NULL;
+  }
+  writer->header.magic = RECORDING_MAGIC;
+  writer->header.version = RECORDING_VERSION;
+  writer->header.numMovements = (uint32_t)numMovements;
+  writer->header.startMs = startMs;
+  // La cabecera definitiva se escribe al cerrar, con el número de eventos
+  if (fwrite(&writer->header, sizeof(RecordingHeader), 1, writer->file) != 1) {
+    fclose(writer->file);
+    free(writer);
+    return NULL;
+  }
+  return writer;
+}
+
+/*
+ * Función: recordDetection
+ * Agrega una detección a la grabación.
+ *
+ * Parámetros:
+ * - writer: Grabación abierta.
+ * - timeMs: ms desde el inicio de la grabación; no puede ser anterior a la detección previa.
+ * - movement: Cruce donde se detectó el vehículo.
+ *
+ * Retorno:
+ * - 0 si se escribió.
+ * - -1 si la detección está fuera de orden, el cruce no existe o falló la escritura.
+ */
+int recordDetection(RecordingWriter *writer, uint64_t timeMs, int movement) {
+  if (timeMs < writer->lastMs || movement < 0 ||
+      movement >= (int)writer->header.numMovements) {
+    return -1;
+  }
+  uint64_t value =
+      (timeMs - writer->lastMs) << RECORDING_MOVEMENT_BITS | (uint64_t)movement;
+  uint8_t bytes[RECORDING_MAX_VARINT];
+  int length = 0;
+  do {
+    bytes[length] = (uint8_t)(value & 0x7f);
+    value >>= 7;
+    if (value != 0) {
+      bytes[length] |= 0x80;
+    }
+    length++;
+  } while (value != 0);
+
+  if (fwrite(bytes, 1, length, writer->file) != (size_t)length) {
+    return -1;
+  }
+  writer->lastMs = timeMs;
+  writer->header.numEvents++;
+  return 0;
+}
+
+/*
+ * Función: closeRecording
+ * Completa la cabecera de la grabación, cierra el archivo y libera el escritor.
+ *
+ * Parámetros:
+ * - writer: Grabación abierta.
+ * - durationMs: Duración de la grabación; si es menor que el tiempo de la última detección se usa este.
+ *
+ * Retorno:
+ * - 0 si el archivo quedó completo.
+ * - -1 si falló la escritura.
+ */
+int closeRecording(RecordingWriter *writer, uint64_t durationMs) {
+  writer->header.durationMs =
+      durationMs > writer->lastMs ? durationMs : writer->lastMs;
+  int ok = fseek(writer->file, 0, SEEK_SET) == 0 &&
+           fwrite(&writer->header, sizeof(RecordingHeader), 1, writer->file) ==
+               1;
+  if (fclose(writer->file) != 0) {
+    ok = 0;
+  }
+  free(writer);
+  return ok ? 0 : -1;
+}
+
+/*
+ * Función: loadRecording
+ * Lee una grabación completa a memoria.
+ *
+ * Retorno:
+ * - Puntero a la grabación, que debe liberarse con freeRecording().
+ * - NULL si el archivo no existe o no es una grabación válida.
+ */
+Recording *loadRecording(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (file == NULL) {
+    printf("Error: No se pudo abrir el archivo %s.\n", filename);
+    return NULL;
+  }
+  Recording *recording = (Recording *)calloc(1, sizeof(Recording));
+  if (recording == NULL ||
+      fread(&recording->header, sizeof(RecordingHeader), 1, file) != 1 ||
+      recording->header.magic != RECORDING_MAGIC ||
+      recording->header.version != RECORDING_VERSION ||
+      recording->header.numMovements > PLAN_MAX_MOVEMENTS) {
+    printf("Error: %s no es una grabacion de detecciones valida.\n", filename);
+    free(recording);
+    fclose(file);
+    return NULL;
+  }
+
+  long begin = ftell(file);
+  long end = -1;
+  if (begin >= 0 && fseek(file, 0, SEEK_END) == 0) {
+    end = ftell(file);
+  }
+  if (end < begin || fseek(file, begin, SEEK_SET) != 0) {
+    printf("Error: No se pudo leer la grabacion %s.\n", filename);
+    free(recording);
+    fclose(file);
+    return NULL;
+  }
+  recording->size = (size_t)(end - begin);
+  recording->data = (uint8_t *)malloc(recording->size + 1);
+  if (recording->data == NULL ||
+      fread(recording->data, 1, recording->size, file) != recording->size) {
+    printf("Error: No se pudo leer la grabacion %s.\n", filename);
+    freeRecording(recording);
+    fclose(file);
+    return NULL;
+  }
+  fclose(file);
+  return recording;
+}
+
+/*
+ * Función: freeRecording
+ * Libera una grabación leída con loadRecording().
+ */
+void freeRecording(Recording *recording) {
+  if (recording) {
+    free(recording->data);
+    free(recording);
+  }
+}
+
+static int compareDetections(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Función: randomUniform
+ * Número en (0, 1] a partir del n-ésimo valor de una secuencia splitmix64; la misma semilla da la misma secuencia.
+ */
+static double randomUniform(uint64_t *state) {
+  uint64_t x = (*state += 0x9e3779b97f4a7c15ull);
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return ((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Función: synthesizeRecording
+ * Genera una grabación de detecciones con llegadas de Poisson según los perfiles de demanda del horario.
+ *
+ * Descripción:
+ * Sirve para probar la reproducción sin detectores reales. Cada cruce es un proceso de Poisson cuya tasa es la
+ * demanda del perfil vigente en cada minuto; se genera por adelgazamiento con la tasa máxima del cruce, de modo que
+ * los cambios de perfil son exactos. Las detecciones de todos los cruces se ordenan por tiempo antes de escribirse.
+ * La grabación empieza a medianoche y el resultado solo depende de la semilla.
+ *
+ * Parámetros:
+ * - filename: Archivo de salida.
+ * - profileSet: Perfiles de demanda de la intersección.
+ * - schedule: Perfil vigente en cada minuto del día (MINUTES_PER_DAY valores).
+ * - numMovements: Vértices del grafo.
+ * - durationMs: Duración de la grabación.
+ * - seed: Semilla del generador.
+ *
+ * Retorno:
+ * - Número de detecciones escritas.
+ * - -1 si no se pudo asignar memoria o escribir el archivo.
+ */
+int synthesizeRecording(const char *filename,
+                        const DemandProfileSet *profileSet,
+                        const uint8_t *schedule, int numMovements,
+                        uint64_t durationMs, uint64_t seed) {
+  double expected = 0;
+  double maxRate[PLAN_MAX_MOVEMENTS] = {0};
+  for (int m = 0; m < numMovements && m < PLAN_MAX_MOVEMENTS; m++) {
+    for (int p = 0; p < profileSet->numProfiles; p++) {
+      double rate = profileSet->profiles[p].flows[m] / MS_PER_HOUR;
+      if (rate > maxRate[m]) {
+        maxRate[m] = rate;
+      }
+    }
+    expected += maxRate[m] * durationMs;
+  }
+
+  size_t capacity = (size_t)(expected * 1.1) + 1024;
+  size_t count = 0;
+  uint64_t *detections = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+  if (detections == NULL) {
+    printf("Error: No se pudo asignar las detecciones en memoria.\n");
+    return -1;
+  }
+
+  uint64_t state = seed;
+  for (int m = 0; m < numMovements && m < PLAN_MAX_MOVEMENTS; m++) {
+    if (maxRate[m] <= 0) {
+      continue;
+    }
+    double time = 0;
+    while ((time += -log(randomUniform(&state)) / maxRate[m]) < durationMs) {
+      int minute = (int)((uint64_t)time / MS_PER_MINUTE % MINUTES_PER_DAY);
+      double rate =
+          profileSet->profiles[schedule[minute]].flows[m] / MS_PER_HOUR;
+      if (randomUniform(&state) * maxRate[m] > rate) {
+        continue;
+      }
+      if (count == capacity) {
+        capacity *= 2;
+        uint64_t *grown =
+            (uint64_t *)realloc(detections, capacity * sizeof(uint64_t));
+        if (grown == NULL) {
+          printf("Error: No se pudo asignar las detecciones en memoria.\n");
+          free(detections);
+          return -1;
+        }
+        detections = grown;
+      }
+      detections[count++] =
+          (uint64_t)time << RECORDING_MOVEMENT_BITS | (uint64_t)m;
+    }
+  }
+  qsort(detections, count, sizeof(uint64_t), compareDetections);
+
+  RecordingWriter *writer = openRecording(filename, numMovements, 0);
+  int status = writer != NULL ? 0 : -1;
+  for (size_t k = 0; k < count && status == 0; k++) {
+    status = recordDetection(
+        writer, detections[k] >> RECORDING_MOVEMENT_BITS,
+        (int)(detections[k] & ((1u << RECORDING_MOVEMENT_BITS) - 1)));
+  }
+  if (writer != NULL && closeRecording(writer, durationMs) != 0) {
+    status = -1;
+  }
+  free(detections);
+  if (status != 0) {
+    printf("Error: No se pudo escribir la grabacion %s.\n", filename);
+    return -1;
+  }
+  return (int)count;
+}
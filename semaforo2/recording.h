@@ -0,0 +1,98 @@
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include "plan_library.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Grabación de las detecciones de una intersección. Formato del archivo:
+// RecordingHeader y luego un evento por detección, en orden de tiempo, como
+// entero de longitud variable (LEB128) con el valor (delta << 6) | cruce,
+// donde delta son los ms desde la detección anterior. Con tráfico normal cada
+// detección ocupa 2 o 3 bytes.
+#define RECORDING_MAGIC 0x43524d53 // "SMRC"
+#define RECORDING_VERSION 1
+#define RECORDING_MOVEMENT_BITS 6 // Cruces < PLAN_MAX_MOVEMENTS
+#define RECORDING_MAX_VARINT 10
+
+typedef struct RecordingHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numMovements; // Vértices del grafo de la intersección
+  uint32_t reserved;
+  uint64_t startMs;    // Hora del día del inicio, en ms desde medianoche
+  uint64_t durationMs; // Duración de la grabación
+  uint64_t numEvents;
+} RecordingHeader;
+
+typedef struct RecordingWriter {
+  FILE *file;
+  RecordingHeader header;
+  uint64_t lastMs; // Tiempo de la última detección escrita
+} RecordingWriter;
+
+// Grabación cargada en memoria para reproducirla
+typedef struct Recording {
+  RecordingHeader header;
+  uint8_t *data; // Eventos codificados
+  size_t size;   // Bytes de data
+} Recording;
+
+typedef struct RecordingCursor {
+  const uint8_t *next;
+  const uint8_t *end;
+  uint64_t timeMs; // Tiempo de la última detección leída
+} RecordingCursor;
+
+static inline void recordingBegin(const Recording *recording,
+                                  RecordingCursor *cursor) {
+  cursor->next = recording->data;
+  cursor->end = recording->data + recording->size;
+  cursor->timeMs = 0;
+}
+
+/*
+ * Función: recordingNext
+ * Decodifica la siguiente detección de la grabación.
+ *
+ * Retorno:
+ * - 1 si se leyó una detección en *timeMs (ms desde el inicio) y *movement.
+ * - 0 al final de la grabación.
+ * - -1 si el evento está truncado.
+ */
+static inline int recordingNext(RecordingCursor *cursor, uint64_t *timeMs,
+                                int *movement) {
+  if (cursor->next >= cursor->end) {
+    return 0;
+  }
+  uint64_t value = 0;
+  for (int shift = 0; shift < 7 * RECORDING_MAX_VARINT; shift += 7) {
+    if (cursor->next >= cursor->end) {
+      return -1;
+    }
+    uint8_t byte = *cursor->next++;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      cursor->timeMs += value >> RECORDING_MOVEMENT_BITS;
+      *timeMs = cursor->timeMs;
+      *movement = (int)(value & ((1u << RECORDING_MOVEMENT_BITS) - 1));
+      return 1;
+    }
+  }
+  return -1;
+}
+
+// Funciones a implementar en recording.c
+RecordingWriter *openRecording(const char *filename, int numMovements,
+                               uint64_t startMs);
+int recordDetection(RecordingWriter *writer, uint64_t timeMs, int movement);
+int closeRecording(RecordingWriter *writer, uint64_t durationMs);
+Recording *loadRecording(const char *filename);
+void freeRecording(Recording *recording);
+int synthesizeRecording(const char *filename,
+                        const DemandProfileSet *profileSet,
+                        const uint8_t *schedule, int numMovements,
+                        uint64_t durationMs, uint64_t seed);
+
+#endif
@@ -0,0 +1,151 @@
+#include "recording.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Prueba de la codificación de las grabaciones: ida y vuelta de (delta << 6) |
+// cruce en LEB128 por openRecording()/recordDetection() y loadRecording()/
+// recordingNext(), con deltas de todas las longitudes de 1 a 9 bytes, el
+// tamaño exacto de cada evento, eventos truncados y detecciones inválidas. Se
+// usa con `make test`.
+#define TEST_EVENTS 20000
+#define TEST_SHORT_DELTA_BITS 21 // (delta << 6) en a lo más 4 bytes
+#define TEST_MAX_DELTA_BITS 57   // (delta << 6) cabe en 63 bits
+#define TEST_LONG_EVERY 200
+
+static int errors = 0;
+
+static void check(bool condition, const char *message) {
+  if (!condition) {
+    printf("Error: %s\n", message);
+    errors++;
+  }
+}
+
+/*
+ * Función: nextRandom
+ * Siguiente valor de una secuencia xorshift64; la misma semilla da la misma secuencia.
+ */
+static uint64_t nextRandom(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/*
+ * Función: varintLength
+ * Bytes que ocupa un valor en LEB128: 7 bits por byte.
+ */
+static size_t varintLength(uint64_t value) {
+  size_t length = 1;
+  while (value >>= 7) {
+    length++;
+  }
+  return length;
+}
+
+int main(void) {
+  char filename[] = "/tmp/recording_testXXXXXX";
+  int fd = mkstemp(filename);
+  if (fd < 0) {
+    printf("Error: No se pudo crear el archivo temporal.\n");
+    return 1;
+  }
+  close(fd);
+
+  static uint64_t times[TEST_EVENTS];
+  static int movements[TEST_EVENTS];
+  uint64_t seed = 0x2545f4914f6cdd1dull;
+  uint64_t time = 0;
+  size_t expectedSize = 0;
+  int lengths[RECORDING_MAX_VARINT + 1] = {0};
+  RecordingWriter *writer = openRecording(filename, PLAN_MAX_MOVEMENTS, 0);
+  if (writer == NULL) {
+    unlink(filename);
+    return 1;
+  }
+  for (int k = 0; k < TEST_EVENTS; k++) {
+    // Deltas de hasta 4 bytes y, cada TEST_LONG_EVERY eventos, de hasta 9
+    // bytes; el último evento ocupa 9 bytes
+    int bits = (int)(nextRandom(&seed) % (k % TEST_LONG_EVERY == 0
+                                              ? TEST_MAX_DELTA_BITS + 1
+                                              : TEST_SHORT_DELTA_BITS + 1));
+    uint64_t delta = bits == 0 ? 0 : nextRandom(&seed) >> (64 - bits);
+    if (k == TEST_EVENTS - 1) {
+      delta = 1ull << (7 * 8 - RECORDING_MOVEMENT_BITS);
+    }
+    if (time + delta < time) {
+      delta = 0; // El tiempo absoluto también debe caber en 64 bits
+    }
+    time += delta;
+    times[k] = time;
+    movements[k] = (int)(nextRandom(&seed) % PLAN_MAX_MOVEMENTS);
+    size_t length =
+        varintLength(delta << RECORDING_MOVEMENT_BITS | (uint64_t)movements[k]);
+    expectedSize += length;
+    lengths[length]++;
+    check(recordDetection(writer, time, movements[k]) == 0,
+          "recordDetection() rechazo una deteccion valida.");
+  }
+  check(recordDetection(writer, time - 1, 0) == -1,
+        "recordDetection() acepto una deteccion fuera de orden.");
+  check(recordDetection(writer, time, PLAN_MAX_MOVEMENTS) == -1,
+        "recordDetection() acepto un cruce inexistente.");
+  check(recordDetection(writer, time, -1) == -1,
+        "recordDetection() acepto un cruce negativo.");
+  check(closeRecording(writer, 0) == 0, "closeRecording() fallo.");
+  for (int length = 1; length < RECORDING_MAX_VARINT; length++) {
+    if (lengths[length] == 0) {
+      printf("Error: Ningun evento ocupo %d bytes.\n", length);
+      errors++;
+    }
+  }
+
+  Recording *recording = loadRecording(filename);
+  unlink(filename);
+  if (recording == NULL) {
+    return 1;
+  }
+  check(recording->header.numEvents == TEST_EVENTS,
+        "La cabecera no tiene el numero de eventos escritos.");
+  check(recording->header.durationMs == time,
+        "La duracion no llega hasta la ultima deteccion.");
+  check(recording->size == expectedSize,
+        "Los eventos no ocupan los bytes de su LEB128.");
+
+  RecordingCursor cursor;
+  recordingBegin(recording, &cursor);
+  uint64_t readTime;
+  int movement, status = 0, read = 0;
+  while ((status = recordingNext(&cursor, &readTime, &movement)) == 1) {
+    if (read < TEST_EVENTS &&
+        (readTime != times[read] || movement != movements[read])) {
+      printf("Error: La deteccion %d se leyo como (%llu, %d) y no (%llu, %d).\n",
+             read, (unsigned long long)readTime, movement,
+             (unsigned long long)times[read], movements[read]);
+      errors++;
+    }
+    read++;
+  }
+  check(status == 0 && read == TEST_EVENTS,
+        "No se leyeron todas las detecciones hasta el final.");
+
+  // Sin el último byte, el último evento (de 9 bytes) queda truncado
+  recording->size--;
+  recordingBegin(recording, &cursor);
+  read = 0;
+  while ((status = recordingNext(&cursor, &readTime, &movement)) == 1) {
+    read++;
+  }
+  check(status == -1 && read == TEST_EVENTS - 1,
+        "Un evento truncado no se informo como tal.");
+  freeRecording(recording);
+
+  printf("recording_test: %d detecciones, %zu bytes (%.2f por deteccion), "
+         "%d errores\n",
+         TEST_EVENTS, expectedSize, (double)expectedSize / TEST_EVENTS, errors);
+  return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+#include "replay.h"
+#include "controller.h"
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define MS_PER_HOUR 3600000u
+#define TICKS_PER_HOUR_INT (MS_PER_HOUR / CONTROLLER_TICK_MS)
+
+// Estado de una reproducción: un controlador con su rueda y la hora del día
+// que se está acumulando
+typedef struct ReplayState {
+  Controller controller;
+  TimerWheel wheel;
+  const ReplayConfig *config;
+  uint64_t startMs;
+  uint64_t nextHour; // Tick en que termina la hora actual
+  int hour;          // Hora del día actual
+  double hourArrivals, hourDelay; // Acumulados al empezar la hora
+  ReplaySummary *summary;
+} ReplayState;
+
+/*
+ * Función: scheduledPlan
+ * Devuelve el plan que rige en el tick `now`, o NULL si el del horario no se pudo construir.
+ */
+static const PhasePlan *scheduledPlan(const ReplayState *state, uint64_t now) {
+  const ReplayConfig *config = state->config;
+  if (config->plan != NULL) {
+    return config->plan;
+  }
+  int minute = (int)((state->startMs + now * CONTROLLER_TICK_MS) / 60000 %
+                     MINUTES_PER_DAY);
+  int profile =
+      config->library->schedule[config->intersection * MINUTES_PER_DAY + minute];
+  if (config->library->status[config->intersection * MAX_PROFILES + profile] !=
+      0) {
+    return NULL;
+  }
+  return getLibraryPlan(config->library, config->intersection, profile);
+}
+
+/*
+ * Función: fireReplay
+ * Aplica el cambio de estado vencido y, al terminar el verde de la última fase, cambia al plan del horario si es
+ * otro.
+ */
+static void fireReplay(TimerNode *timer, uint64_t now, void *context) {
+  ReplayState *state = (ReplayState *)context;
+  const ReplayConfig *config = state->config;
+  Controller *controller = timerController(timer);
+  const PhasePlan *current = controller->plan;
+  const PhasePlan *plan = NULL;
+  if (config->plan == NULL && !controller->clearing &&
+      controller->phase == current->numPhases - 1) {
+    plan = scheduledPlan(state, now);
+  }
+
+  uint64_t next;
+  if (plan != NULL && plan != current) {
+    const PhasePlan *first = getLibraryPlan(config->library,
+                                            config->intersection, 0);
+    uint16_t clearance =
+        getSwitchIntergreen(config->library, config->intersection,
+                            (int)(current - first), (int)(plan - first));
+    next = controllerSetPlan(controller, plan, clearance, now);
+    state->summary->planChanges++;
+  } else {
+    next = controllerAdvance(controller, now);
+  }
+  state->summary->transitions++;
+  if (next != UINT64_MAX) {
+    timerWheelAdd(&state->wheel, timer, next);
+  }
+}
+
+/*
+ * Función: closeHour
+ * Asigna a la hora actual las llegadas y la demora acumuladas hasta el tick `now`.
+ */
+static void closeHour(ReplayState *state, uint64_t now) {
+  Controller *controller = &state->controller;
+  controllerSettle(controller, now);
+  state->summary->hourArrivals[state->hour] +=
+      controller->arrivals - state->hourArrivals;
+  state->summary->hourDelay[state->hour] +=
+      controller->delay - state->hourDelay;
+  state->hourArrivals = controller->arrivals;
+  state->hourDelay = controller->delay;
+}
+
+/*
+ * Función: advanceTo
+ * Avanza el tiempo virtual hasta el tick `now`, cerrando las horas del día que terminen antes.
+ */
+static void advanceTo(ReplayState *state, uint64_t now) {
+  while (state->nextHour <= now) {
+    timerWheelAdvance(&state->wheel, state->nextHour, fireReplay, state);
+    closeHour(state, state->nextHour);
+    state->hour = (state->hour + 1) % HOURS_PER_DAY;
+    state->nextHour += TICKS_PER_HOUR_INT;
+  }
+  timerWheelAdvance(&state->wheel, now, fireReplay, state);
+}
+
+/*
+ * Función: replayRecording
+ * Reproduce una grabación de detecciones sobre un controlador en tiempo virtual.
+ *
+ * Descripción:
+ * Cada detección es la llegada de un vehículo a la cola de su cruce en el tick de CONTROLLER_TICK_MS que le
+ * corresponde; entre detecciones la rueda de tiempo aplica los cambios de fase del plan. No se espera al reloj, así
+ * que un día de tráfico se reproduce en lo que tarda en procesarse, y el resultado solo depende de la grabación y
+ * del plan. Las colas no tienen demanda de fondo: solo crecen con las detecciones.
+ *
+ * Parámetros:
+ * - recording: Grabación cargada con loadRecording().
+ * - config: Plan fijo o biblioteca con horario; sus cruces deben ser los de la grabación.
+ * - summary: Resultado.
+ *
+ * Retorno:
+ * - 0 si se reprodujo toda la grabación.
+ * - -1 si el plan no corresponde a la grabación o la grabación está dañada.
+ */
+int replayRecording(const Recording *recording, const ReplayConfig *config,
+                    ReplaySummary *summary) {
+  ReplayState state;
+  memset(summary, 0, sizeof(ReplaySummary));
+  state.config = config;
+  state.summary = summary;
+  state.startMs = recording->header.startMs;
+  state.hour = (int)(state.startMs / MS_PER_HOUR % HOURS_PER_DAY);
+  state.nextHour = (MS_PER_HOUR - state.startMs % MS_PER_HOUR +
+                    CONTROLLER_TICK_MS - 1) /
+                   CONTROLLER_TICK_MS;
+  state.hourArrivals = 0;
+  state.hourDelay = 0;
+
+  const PhasePlan *plan = scheduledPlan(&state, 0);
+  if (plan == NULL ||
+      plan->numMovements != (int)recording->header.numMovements) {
+    printf("Error: El plan no corresponde a los %u cruces de la grabacion.\n",
+           recording->header.numMovements);
+    return -1;
+  }
+  Controller *controller = &state.controller;
+  controllerInit(controller, config->intersection, plan, NULL, 0);
+  timerWheelInit(&state.wheel, 0);
+  if (controller->changeTime != UINT64_MAX) {
+    timerWheelAdd(&state.wheel, &controller->timer, controller->changeTime);
+  }
+
+  RecordingCursor cursor;
+  recordingBegin(recording, &cursor);
+  uint64_t timeMs;
+  int movement, status;
+  while ((status = recordingNext(&cursor, &timeMs, &movement)) == 1) {
+    uint64_t now = timeMs / CONTROLLER_TICK_MS;
+    advanceTo(&state, now);
+    controllerArrival(controller, movement, now);
+    summary->events++;
+    summary->movementArrivals[movement]++;
+    if (controller->queue[movement] > summary->maxQueue[movement]) {
+      summary->maxQueue[movement] = controller->queue[movement];
+    }
+  }
+  if (status != 0) {
+    printf("Error: La grabacion esta truncada tras %lu detecciones.\n",
+           (unsigned long)summary->events);
+    return -1;
+  }
+
+  summary->ticks = (recording->header.durationMs + CONTROLLER_TICK_MS - 1) /
+                   CONTROLLER_TICK_MS;
+  advanceTo(&state, summary->ticks);
+  closeHour(&state, summary->ticks);
+  summary->arrivals = controller->arrivals;
+  summary->departures = controller->departures;
+  summary->delay = controller->delay;
+  for (int i = 0; i < plan->numMovements; i++) {
+    summary->residualQueue += controller->queue[i];
+  }
+  return 0;
+}
+
+/*
+ * Función: averageDelay
+ * Demora media en segundos por vehículo a partir de la demora acumulada en vehículos x tick.
+ */
+static double averageDelay(double delay, double arrivals) {
+  return arrivals > 0 ? delay / arrivals * CONTROLLER_TICK_MS / 1e3 : 0.0;
+}
+
+/*
+ * Función: printReplayComparison
+ * Imprime lado a lado los resultados de reproducir la misma grabación con varios planes.
+ *
+ * Parámetros:
+ * - names: Nombre de cada columna.
+ * - plans: Plan fijo de cada columna, o NULL si se usó el horario de la biblioteca.
+ * - summaries: Resultado de cada columna.
+ * - count: Número de columnas.
+ */
+void printReplayComparison(char **names, const PhasePlan **plans,
+                           const ReplaySummary *summaries, int count) {
+  printf("%-20s", "");
+  for (int k = 0; k < count; k++) {
+    printf("%12s", names[k]);
+  }
+  printf("\n%-20s", "Ciclo (s)");
+  for (int k = 0; k < count; k++) {
+    if (plans[k] != NULL) {
+      printf("%12.1f", plans[k]->cycle / 10.0);
+    } else {
+      printf("%12s", "-");
+    }
+  }
+  printf("\n%-20s", "Demora (s/veh)");
+  for (int k = 0; k < count; k++) {
+    printf("%12.1f", averageDelay(summaries[k].delay, summaries[k].arrivals));
+  }
+  printf("\n%-20s", "Atendidos (veh/h)");
+  for (int k = 0; k < count; k++) {
+    double hours = summaries[k].ticks / TICKS_PER_HOUR;
+    printf("%12.0f", hours > 0 ? summaries[k].departures / hours : 0.0);
+  }
+  printf("\n%-20s", "Cola maxima (veh)");
+  for (int k = 0; k < count; k++) {
+    float maxQueue = 0;
+    for (int i = 0; i < PLAN_MAX_MOVEMENTS; i++) {
+      if (summaries[k].maxQueue[i] > maxQueue) {
+        maxQueue = summaries[k].maxQueue[i];
+      }
+    }
+    printf("%12.1f", maxQueue);
+  }
+  printf("\n%-20s", "Cola final (veh)");
+  for (int k = 0; k < count; k++) {
+    printf("%12.1f", summaries[k].residualQueue);
+  }
+  printf("\n%-20s", "Cambios de estado");
+  for (int k = 0; k < count; k++) {
+    printf("%12lu", (unsigned long)summaries[k].transitions);
+  }
+  printf("\n%-20s", "Cambios de plan");
+  for (int k = 0; k < count; k++) {
+    printf("%12d", summaries[k].planChanges);
+  }
+
+  printf("\nDemora por hora (s/veh):\n");
+  for (int h = 0; h < HOURS_PER_DAY; h++) {
+    if (count == 0 || summaries[0].hourArrivals[h] == 0) {
+      continue;
+    }
+    printf("  %02d:00%13s", h, "");
+    for (int k = 0; k < count; k++) {
+      printf("%12.1f", averageDelay(summaries[k].hourDelay[h],
+                                    summaries[k].hourArrivals[h]));
+    }
+    printf("\n");
+  }
+}
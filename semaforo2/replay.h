@@ -0,0 +1,43 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "phase_plan.h"
+#include "plan_library.h"
+#include "recording.h"
+#include <stdint.h>
+
+#define HOURS_PER_DAY 24
+
+// Plan con el que se reproduce una grabación: uno fijo o, si plan es NULL, el
+// que indique el horario de la biblioteca para la intersección, cambiando al
+// terminar el verde de la última fase con el despeje de getSwitchIntergreen()
+typedef struct ReplayConfig {
+  const PhasePlan *plan;
+  const PlanLibrary *library;
+  int intersection;
+} ReplayConfig;
+
+// Resultado de una reproducción. Todo se mide en tiempo virtual, así que dos
+// reproducciones de la misma grabación con el mismo plan dan lo mismo.
+typedef struct ReplaySummary {
+  uint64_t events;       // Detecciones reproducidas
+  uint64_t ticks;        // Duración simulada
+  uint64_t transitions;  // Cambios de estado del controlador
+  int planChanges;       // Cambios de plan por horario
+  double arrivals;
+  double departures;
+  double delay;          // Vehículos x tick de espera
+  double residualQueue;  // Vehículos en espera al final
+  float maxQueue[PLAN_MAX_MOVEMENTS];
+  double movementArrivals[PLAN_MAX_MOVEMENTS];
+  double hourArrivals[HOURS_PER_DAY]; // Por hora del día
+  double hourDelay[HOURS_PER_DAY];
+} ReplaySummary;
+
+// Funciones a implementar en replay.c
+int replayRecording(const Recording *recording, const ReplayConfig *config,
+                    ReplaySummary *summary);
+void printReplayComparison(char **names, const PhasePlan **plans,
+                           const ReplaySummary *summaries, int count);
+
+#endif
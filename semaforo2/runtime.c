@@ -0,0 +1,416 @@
+#define _GNU_SOURCE // pthread_setaffinity_np
+#include "runtime.h"
+#include "controller.h"
+#include "phase_plan.h"
+#include "timer_wheel.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TICK_NS ((uint64_t)CONTROLLER_TICK_MS * 1000000u)
+
+static inline uint64_t timespecToNs(const struct timespec *time) {
+  return (uint64_t)time->tv_sec * 1000000000u + (uint64_t)time->tv_nsec;
+}
+
+static inline uint64_t monotonicNs(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return timespecToNs(&now);
+}
+
+/*
+ * Función: fireController
+ * Aplica el cambio de estado vencido de un controlador y programa el siguiente en la rueda del fragmento.
+ */
+static void fireController(TimerNode *timer, uint64_t now, void *context) {
+  Shard *shard = (Shard *)context;
+  uint64_t next = controllerAdvance(timerController(timer), now);
+  shard->metrics.transitions++;
+  if (next != UINT64_MAX) {
+    timerWheelAdd(&shard->wheel, timer, next);
+  }
+}
+
+/*
+ * Función: recordLatency
+ * Agrega la latencia de un tick a las métricas del fragmento.
+ */
+static void recordLatency(ShardMetrics *metrics, uint64_t latency) {
+  int bucket = 63 - __builtin_clzll(latency | 1);
+  if (bucket >= LATENCY_BUCKETS) {
+    bucket = LATENCY_BUCKETS - 1;
+  }
+  metrics->latencyHistogram[bucket]++;
+  metrics->latencyTotal += latency;
+  if (latency > metrics->latencyMax) {
+    metrics->latencyMax = latency;
+  }
+}
+
+/*
+ * Función: publishSnapshots
+ * Publica el estado de los controladores del fragmento que se muestran en vivo.
+ *
+ * Descripción:
+ * Los controladores que publican son los primeros de cada fragmento, porque la intersección i está en la posición
+ * i / numShards. Se escribe la copia que no es la vigente y luego se avanza el contador, así que publicar nunca
+ * espera a los lectores.
+ */
+static void publishSnapshots(Shard *shard, uint64_t now) {
+  Runtime *runtime = shard->runtime;
+  for (int c = 0; c < shard->numControllers &&
+                  shard->controllers[c].id < runtime->config.numSnapshots;
+       c++) {
+    Controller *controller = &shard->controllers[c];
+    SnapshotSlot *slot = &runtime->snapshots[controller->id];
+    controllerSettle(controller, now);
+
+    unsigned sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    unsigned version = (sequence >> 1) + 1;
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    ControllerSnapshot *snapshot = &slot->copies[version & 1];
+    snapshot->tick = now;
+    snapshot->remaining = controller->changeTime != UINT64_MAX
+                              ? controller->changeTime - now
+                              : 0;
+    snapshot->greenMask = controllerGreenMask(controller);
+    snapshot->phase = controller->phase;
+    snapshot->next = controller->next;
+    snapshot->clearing = controller->clearing;
+    snapshot->numPhases = (uint8_t)controller->plan->numPhases;
+    snapshot->numMovements = controller->plan->numMovements;
+    memcpy(snapshot->queue, controller->queue,
+           controller->plan->numMovements * sizeof(float));
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+  }
+}
+
+/*
+ * Función: shardThread
+ * Cuerpo del hilo de un fragmento: avanza su rueda un tick cada CONTROLLER_TICK_MS.
+ *
+ * Descripción:
+ * Los plazos son absolutos (clock_nanosleep con TIMER_ABSTIME), así que un tick lento no desplaza a los
+ * siguientes: si el hilo se atrasa, procesa los ticks pendientes sin dormir y los cuenta como plazos perdidos. En
+ * modo simulado no se espera al reloj y la latencia es solo el tiempo de procesamiento. El ciclo no asigna
+ * memoria: los controladores y sus temporizadores se crearon con el fragmento.
+ */
+static void *shardThread(void *arg) {
+  Shard *shard = (Shard *)arg;
+  Runtime *runtime = shard->runtime;
+  bool realTime = runtime->config.realTime;
+
+  if (shard->cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(shard->cpu, &cpus);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0) {
+      shard->cpu = -1;
+    }
+  }
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  uint64_t tick = shard->wheel.now;
+  while (atomic_load_explicit(&runtime->running, memory_order_relaxed) &&
+         (runtime->config.duration == 0 ||
+          tick < runtime->config.duration)) {
+    tick++;
+    uint64_t begin;
+    if (realTime) {
+      deadline.tv_nsec += TICK_NS;
+      while (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_nsec -= 1000000000;
+        deadline.tv_sec++;
+      }
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+      begin = timespecToNs(&deadline);
+    } else {
+      begin = monotonicNs();
+    }
+
+    timerWheelAdvance(&shard->wheel, tick, fireController, shard);
+    publishSnapshots(shard, tick);
+
+    uint64_t end = monotonicNs();
+    uint64_t latency = end > begin ? end - begin : 0;
+    recordLatency(&shard->metrics, latency);
+    if (realTime && latency > TICK_NS) {
+      shard->metrics.missedDeadlines++;
+    }
+    shard->metrics.ticks++;
+  }
+  return NULL;
+}
+
+/*
+ * Función: createRuntime
+ * Crea el entorno de ejecución con un controlador por intersección repartidos en fragmentos.
+ *
+ * Descripción:
+ * La intersección i va al fragmento i % numShards. Todos los controladores se crean aquí, cada uno con su
+ * temporizador programado en la rueda de su fragmento; los inicios de ciclo se escalonan para que los cambios de
+ * fase de las intersecciones no coincidan en el mismo tick.
+ *
+ * Parámetros:
+ * - config: Configuración; numShards se limita al número de intersecciones y a RUNTIME_MAX_SHARDS.
+ * - plans: Plan de cada intersección; deben seguir existiendo mientras exista el entorno.
+ * - flows: Demanda de cada intersección en veh/h para las colas (NULL, o NULL por intersección, sin demanda).
+ * - numIntersections: Número de intersecciones.
+ *
+ * Retorno:
+ * - Puntero al entorno, que debe liberarse con freeRuntime().
+ * - NULL si no hay intersecciones o no se puede asignar memoria.
+ */
+Runtime *createRuntime(const RuntimeConfig *config, const PhasePlan **plans,
+                       const double **flows, int numIntersections) {
+  if (numIntersections < 1) {
+    printf("Error: El entorno de ejecucion necesita al menos una "
+           "interseccion.\n");
+    return NULL;
+  }
+  Runtime *runtime = (Runtime *)calloc(1, sizeof(Runtime));
+  if (runtime == NULL) {
+    printf("Error: No se pudo asignar el entorno de ejecucion en memoria.\n");
+    return NULL;
+  }
+  runtime->config = *config;
+  int numShards = config->numShards;
+  if (numShards < 1) {
+    numShards = 1;
+  }
+  if (numShards > RUNTIME_MAX_SHARDS) {
+    numShards = RUNTIME_MAX_SHARDS;
+  }
+  if (numShards > numIntersections) {
+    numShards = numIntersections;
+  }
+  runtime->config.numShards = numShards;
+  runtime->numIntersections = numIntersections;
+  atomic_init(&runtime->running, false);
+  if (runtime->config.numSnapshots > numIntersections) {
+    runtime->config.numSnapshots = numIntersections;
+  }
+  if (runtime->config.numSnapshots > 0) {
+    runtime->snapshots = (SnapshotSlot *)aligned_alloc(
+        64, runtime->config.numSnapshots * sizeof(SnapshotSlot));
+    if (runtime->snapshots == NULL) {
+      printf("Error: No se pudo asignar las instantaneas en memoria.\n");
+      free(runtime);
+      return NULL;
+    }
+    for (int i = 0; i < runtime->config.numSnapshots; i++) {
+      atomic_init(&runtime->snapshots[i].sequence, 0);
+    }
+  }
+
+  runtime->shards = (Shard *)aligned_alloc(64, numShards * sizeof(Shard));
+  if (runtime->shards == NULL) {
+    printf("Error: No se pudo asignar los fragmentos en memoria.\n");
+    free(runtime->snapshots);
+    free(runtime);
+    return NULL;
+  }
+  int numCpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  for (int s = 0; s < numShards; s++) {
+    Shard *shard = &runtime->shards[s];
+    shard->index = s;
+    shard->cpu = config->pinThreads && numCpus > 0 ? s % numCpus : -1;
+    shard->numControllers = 0;
+    shard->controllers = (Controller *)malloc(
+        ((numIntersections + numShards - 1) / numShards) * sizeof(Controller));
+    if (shard->controllers == NULL) {
+      printf("Error: No se pudo asignar los controladores en memoria.\n");
+      while (s-- > 0) {
+        free(runtime->shards[s].controllers);
+      }
+      free(runtime->shards);
+      free(runtime->snapshots);
+      free(runtime);
+      return NULL;
+    }
+    shard->runtime = runtime;
+    timerWheelInit(&shard->wheel, 0);
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+      shard->metrics.latencyHistogram[b] = 0;
+    }
+    shard->metrics.ticks = 0;
+    shard->metrics.transitions = 0;
+    shard->metrics.missedDeadlines = 0;
+    shard->metrics.latencyTotal = 0;
+    shard->metrics.latencyMax = 0;
+  }
+
+  for (int i = 0; i < numIntersections; i++) {
+    Shard *shard = &runtime->shards[i % numShards];
+    Controller *controller = &shard->controllers[shard->numControllers++];
+    const PhasePlan *plan = plans[i];
+    uint64_t start = plan->cycle > 0 ? (uint64_t)i * 7919 % plan->cycle : 0;
+    controllerInit(controller, i, plan, flows != NULL ? flows[i] : NULL,
+                   start);
+    if (controller->changeTime != UINT64_MAX) {
+      timerWheelAdd(&shard->wheel, &controller->timer, controller->changeTime);
+    }
+  }
+  return runtime;
+}
+
+/*
+ * Función: startRuntime
+ * Crea el hilo de cada fragmento.
+ *
+ * Retorno:
+ * - 0 si se crearon todos los hilos.
+ * - -1 si no se pudo crear alguno; los creados siguen corriendo hasta stopRuntime().
+ */
+int startRuntime(Runtime *runtime) {
+  atomic_store(&runtime->running, true);
+  for (int s = 0; s < runtime->config.numShards; s++) {
+    if (pthread_create(&runtime->shards[s].thread, NULL, shardThread,
+                       &runtime->shards[s]) != 0) {
+      printf("Error: No se pudo crear el hilo del fragmento %d.\n", s);
+      return -1;
+    }
+    runtime->started++;
+  }
+  return 0;
+}
+
+/*
+ * Función: waitRuntime
+ * Espera a que terminen los hilos de los fragmentos (al cumplirse config.duration o después de stopRuntime()).
+ */
+void waitRuntime(Runtime *runtime) {
+  for (int s = 0; s < runtime->started; s++) {
+    pthread_join(runtime->shards[s].thread, NULL);
+  }
+  runtime->started = 0;
+  atomic_store(&runtime->running, false);
+}
+
+/*
+ * Función: stopRuntime
+ * Detiene los fragmentos al terminar su tick en curso y espera sus hilos.
+ */
+void stopRuntime(Runtime *runtime) {
+  atomic_store(&runtime->running, false);
+  waitRuntime(runtime);
+}
+
+/*
+ * Función: freeRuntime
+ * Detiene el entorno si sigue corriendo y libera su memoria.
+ */
+void freeRuntime(Runtime *runtime) {
+  if (runtime) {
+    stopRuntime(runtime);
+    for (int s = 0; s < runtime->config.numShards; s++) {
+      free(runtime->shards[s].controllers);
+    }
+    free(runtime->shards);
+    free(runtime->snapshots);
+    free(runtime);
+  }
+}
+
+/*
+ * Función: latencyPercentile
+ * Estima un percentil de la latencia de los ticks como el límite superior de su cubeta.
+ */
+static uint64_t latencyPercentile(const ShardMetrics *metrics,
+                                  double fraction) {
+  uint64_t target = (uint64_t)(metrics->ticks * fraction);
+  uint64_t count = 0;
+  for (int b = 0; b < LATENCY_BUCKETS; b++) {
+    count += metrics->latencyHistogram[b];
+    if (count > target) {
+      return (uint64_t)2 << b;
+    }
+  }
+  return metrics->latencyMax;
+}
+
+/*
+ * Función: printRuntimeMetrics
+ * Imprime las métricas de cada fragmento y el desempeño de las intersecciones.
+ *
+ * Descripción:
+ * Debe llamarse con los fragmentos detenidos, ya que lee sus métricas y controladores sin sincronización.
+ */
+void printRuntimeMetrics(Runtime *runtime) {
+  double delay = 0, arrivals = 0, departures = 0;
+  uint64_t ticks = 0;
+  for (int s = 0; s < runtime->config.numShards; s++) {
+    Shard *shard = &runtime->shards[s];
+    ShardMetrics *metrics = &shard->metrics;
+    printf("Fragmento %d (nucleo %d): %d intersecciones, %lu ticks, %lu "
+           "cambios, latencia media %.1f us, p99 < %.1f us, max %.1f us, "
+           "%lu plazos perdidos\n",
+           s, shard->cpu, shard->numControllers, (unsigned long)metrics->ticks,
+           (unsigned long)metrics->transitions,
+           metrics->ticks ? metrics->latencyTotal / 1e3 / metrics->ticks : 0.0,
+           latencyPercentile(metrics, 0.99) / 1e3, metrics->latencyMax / 1e3,
+           (unsigned long)metrics->missedDeadlines);
+    for (int c = 0; c < shard->numControllers; c++) {
+      controllerSettle(&shard->controllers[c], shard->wheel.now);
+      delay += shard->controllers[c].delay;
+      arrivals += shard->controllers[c].arrivals;
+      departures += shard->controllers[c].departures;
+    }
+    if (metrics->ticks > ticks) {
+      ticks = metrics->ticks;
+    }
+  }
+
+  double hours = ticks / TICKS_PER_HOUR;
+  printf("%d intersecciones, %.1f s simulados: demora media %.1f s/veh, "
+         "%.0f veh/h atendidos por interseccion\n",
+         runtime->numIntersections, ticks * CONTROLLER_TICK_MS / 1e3,
+         arrivals > 0 ? delay / arrivals * CONTROLLER_TICK_MS / 1e3 : 0.0,
+         hours > 0 ? departures / hours / runtime->numIntersections : 0.0);
+}
+
+/*
+ * Función: readControllerSnapshot
+ * Copia el último estado publicado de una intersección sin detener a su fragmento.
+ *
+ * Descripción:
+ * Igual que readPlan(): lee la copia vigente y la descarta si el contador avanzó más de una publicación mientras se
+ * copiaba. Puede llamarse desde cualquier hilo mientras el entorno corre.
+ *
+ * Parámetros:
+ * - runtime: Entorno de ejecución.
+ * - intersection: Intersección, menor que config.numSnapshots.
+ * - snapshot: Donde se copia el estado.
+ *
+ * Retorno:
+ * - 0 si se copió el estado.
+ * - -1 si la intersección no publica su estado o todavía no ha publicado nada.
+ */
+int readControllerSnapshot(const Runtime *runtime, int intersection,
+                           ControllerSnapshot *snapshot) {
+  if (intersection < 0 || intersection >= runtime->config.numSnapshots) {
+    return -1;
+  }
+  SnapshotSlot *slot = &runtime->snapshots[intersection];
+  unsigned sequence, after;
+  do {
+    sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence < 2) {
+      return -1; // La primera publicación no ha terminado
+    }
+    memcpy(snapshot, &slot->copies[(sequence >> 1) & 1],
+           sizeof(ControllerSnapshot));
+    atomic_thread_fence(memory_order_acquire);
+    after = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+  } while (after - (sequence & ~1u) > 2);
+  return 0;
+}
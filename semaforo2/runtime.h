@@ -0,0 +1,89 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include "controller.h"
+#include "phase_plan.h"
+#include "timer_wheel.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RUNTIME_MAX_SHARDS 256
+#define LATENCY_BUCKETS 32 // Cubeta b: latencias en [2^b, 2^(b+1)) ns
+
+typedef struct RuntimeConfig {
+  int numShards;       // Hilos del grupo fijo; cada uno con su rueda
+  uint64_t duration;   // Ticks a ejecutar, 0 para ejecutar hasta stopRuntime()
+  bool realTime;       // false: avanza sin esperar al reloj (simulación)
+  bool pinThreads;     // Fija cada hilo a un núcleo
+  int numSnapshots;    // Intersecciones 0..numSnapshots-1 publican su estado
+} RuntimeConfig;
+
+// Estado de una intersección al final de un tick, para mostrarlo en vivo
+typedef struct ControllerSnapshot {
+  uint64_t tick;
+  uint64_t remaining; // Ticks hasta el siguiente cambio de estado
+  uint64_t greenMask;
+  uint8_t phase;
+  uint8_t next;
+  uint8_t clearing;
+  uint8_t numPhases;
+  int numMovements;
+  float queue[PLAN_MAX_MOVEMENTS];
+} ControllerSnapshot;
+
+// Publicación sin candados del hilo del fragmento a los lectores, con el
+// mismo contador de secuencia y doble copia de PlanSlot: el hilo nunca espera
+// a un lector y el lector reintenta si la copia cambió mientras la leía
+typedef struct SnapshotSlot {
+  _Alignas(64) atomic_uint sequence; // Menor que 2 hasta la primera publicación
+  ControllerSnapshot copies[2];
+} SnapshotSlot;
+
+// Métricas de un fragmento, escritas solo por su hilo. La latencia de un tick
+// es el tiempo entre su plazo y el fin de su procesamiento; el plazo se pierde
+// si el procesamiento termina después del plazo del tick siguiente.
+typedef struct ShardMetrics {
+  uint64_t ticks;
+  uint64_t transitions;
+  uint64_t missedDeadlines;
+  uint64_t latencyTotal; // ns
+  uint64_t latencyMax;   // ns
+  uint64_t latencyHistogram[LATENCY_BUCKETS];
+} ShardMetrics;
+
+// Fragmento: un hilo con sus intersecciones y su rueda. Nada de esto se
+// comparte con otros hilos mientras corre, así que no hay candados.
+typedef struct Shard {
+  _Alignas(64) int index;
+  int cpu; // Núcleo al que se fija, o -1
+  int numControllers;
+  Controller *controllers;
+  TimerWheel wheel;
+  ShardMetrics metrics;
+  struct Runtime *runtime;
+  pthread_t thread;
+} Shard;
+
+typedef struct Runtime {
+  RuntimeConfig config;
+  int numIntersections;
+  Shard *shards;
+  SnapshotSlot *snapshots; // config.numSnapshots ranuras
+  int started; // Hilos creados
+  atomic_bool running;
+} Runtime;
+
+// Funciones a implementar en runtime.c
+Runtime *createRuntime(const RuntimeConfig *config, const PhasePlan **plans,
+                       const double **flows, int numIntersections);
+int startRuntime(Runtime *runtime);
+void waitRuntime(Runtime *runtime);
+void stopRuntime(Runtime *runtime);
+void freeRuntime(Runtime *runtime);
+void printRuntimeMetrics(Runtime *runtime);
+int readControllerSnapshot(const Runtime *runtime, int intersection,
+                           ControllerSnapshot *snapshot);
+
+#endif
@@ -0,0 +1,429 @@
+#include "sequencing.h"
+#include "bitset.h"
+#include "conflicts.h"
+#include "graph.h"
+#include "traffic_lights.h"
+
+#include <float.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Función: getClearance
+ * Devuelve el tiempo de despeje entre el fin del cruce `from` y el inicio del cruce `to`.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - conflicts: Matriz de conflictos del grafo, de buildConflictMatrix().
+ * - from: Índice del cruce que termina su verde.
+ * - to: Índice del cruce que inicia su verde.
+ *
+ * Retorno:
+ * - El valor de la sección [despeje] si fue especificado.
+ * - DEFAULT_CLEARANCE si los cruces son incompatibles, 0 en caso contrario.
+ */
+double getClearance(Graph *graph, ConflictMatrix *conflicts, int from,
+                    int to) {
+  int n = graph->numVertices;
+  if (graph->clearance != NULL && graph->clearance[from * n + to] >= 0) {
+    return graph->clearance[from * n + to];
+  }
+  return bitsetTest(conflictRow(conflicts, from), to) ? DEFAULT_CLEARANCE : 0;
+}
+
+/*
+ * Función: maskTransition
+ * Calcula el despeje entre dos fases dadas como máscaras de cruces (a lo más 64), aunque sean de planes distintos.
+ *
+ * Descripción:
+ * Es el mismo costo que buildTransitionMatrix(): el mayor despeje entre un cruce que se detiene y uno que arranca.
+ * Sirve para cambiar de plan, cuando la fase de origen es del plan anterior y la de destino del nuevo.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - conflicts: Matriz de conflictos del grafo, de buildConflictMatrix().
+ * - from: Cruces de la fase que termina.
+ * - to: Cruces de la fase que inicia.
+ *
+ * Retorno:
+ * - Despeje en segundos.
+ */
+double maskTransition(Graph *graph, ConflictMatrix *conflicts, uint64_t from,
+                      uint64_t to) {
+  uint64_t stopping = from & ~to;
+  uint64_t starting = to & ~from;
+  double worst = 0;
+  for (int i = bitsetNext(&stopping, 1, 0); i != -1;
+       i = bitsetNext(&stopping, 1, i + 1)) {
+    for (int j = bitsetNext(&starting, 1, 0); j != -1;
+         j = bitsetNext(&starting, 1, j + 1)) {
+      double time = getClearance(graph, conflicts, i, j);
+      if (time > worst) {
+        worst = time;
+      }
+    }
+  }
+  return worst;
+}
+
+/*
+ * Función: buildTransitionMatrix
+ * Calcula el tiempo perdido en cada transición posible entre dos fases.
+ *
+ * Descripción:
+ * Al pasar de la fase A a la fase B se detienen los cruces de A que no están en B y arrancan los cruces de B que no
+ * están en A. El verde de B no puede comenzar hasta que termine el mayor despeje entre un cruce que se detiene y uno
+ * que arranca, por lo que ese máximo es el costo de la transición A -> B. La matriz resultante no es simétrica.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - groupList: Lista de grupos (fases).
+ * - numGroups: Número de grupos de la lista.
+ *
+ * Retorno:
+ * - Arreglo de numGroups * numGroups valores (fila = fase de origen) que debe liberarse con free().
+ * - NULL si no se puede asignar memoria.
+ */
+double *buildTransitionMatrix(Graph *graph, GroupList *groupList,
+                              int numGroups) {
+  int n = graph->numVertices;
+  ConflictMatrix *conflicts = buildConflictMatrix(graph);
+  if (conflicts == NULL) {
+    return NULL;
+  }
+  int words = conflicts->words;
+
+  // Pertenencia de cada cruce a cada grupo
+  uint64_t *member =
+      (uint64_t *)malloc((size_t)numGroups * words * sizeof(uint64_t));
+  double *transition =
+      (double *)calloc((size_t)numGroups * numGroups, sizeof(double));
+  if (member == NULL || transition == NULL) {
+    printf("Error: No se pudo asignar la matriz de transiciones en memoria.\n");
+    free(transition);
+    free(member);
+    freeConflictMatrix(conflicts);
+    return NULL;
+  }
+  Group *currentGroup = groupList->head;
+  for (int g = 0; g < numGroups; g++) {
+    groupToBitset(graph, currentGroup, member + (size_t)g * words, words);
+    currentGroup = currentGroup->next;
+  }
+
+  for (int a = 0; a < numGroups; a++) {
+    uint64_t *fromSet = member + (size_t)a * words;
+    for (int b = 0; b < numGroups; b++) {
+      if (a == b) {
+        continue;
+      }
+      uint64_t *toSet = member + (size_t)b * words;
+      double worst = 0;
+      for (int i = 0; i < n; i++) {
+        // Cruces que se detienen
+        if (!bitsetTest(fromSet, i) || bitsetTest(toSet, i)) {
+          continue;
+        }
+        for (int j = 0; j < n; j++) {
+          // Cruces que arrancan
+          if (!bitsetTest(toSet, j) || bitsetTest(fromSet, j)) {
+            continue;
+          }
+          double time = getClearance(graph, conflicts, i, j);
+          if (time > worst) {
+            worst = time;
+          }
+        }
+      }
+      transition[a * numGroups + b] = worst;
+    }
+  }
+
+  free(member);
+  freeConflictMatrix(conflicts);
+  return transition;
+}
+
+/*
+ * Función: cycleLostTime
+ * Suma el tiempo perdido de todas las transiciones de un ciclo, incluida la vuelta de la última fase a la primera.
+ *
+ * Parámetros:
+ * - transition: Matriz de transiciones de buildTransitionMatrix().
+ * - numGroups: Número de fases.
+ * - order: Permutación de las fases.
+ *
+ * Retorno:
+ * - Tiempo perdido por ciclo en segundos.
+ */
+double cycleLostTime(double *transition, int numGroups, int *order) {
+  if (numGroups < 2) {
+    return 0;
+  }
+  double total = 0;
+  for (int k = 0; k < numGroups; k++) {
+    int from = order[k];
+    int to = order[(k + 1) % numGroups];
+    total += transition[from * numGroups + to];
+  }
+  return total;
+}
+
+/*
+ * Función: sequenceExact
+ * Ordena las fases de forma óptima con programación dinámica sobre subconjuntos (Held-Karp).
+ *
+ * Descripción:
+ * Como el orden es cíclico, la fase 0 se fija como primera. cost[mask][j] es el menor tiempo perdido de un camino que
+ * parte de la fase 0, visita exactamente las fases de `mask` y termina en la fase j. La complejidad es
+ * O(2^n * n^2), por lo que solo se usa con n <= MAX_EXACT_PHASES. Devuelve -1 si no hay memoria para la tabla.
+ */
+double sequenceExact(double *transition, int numGroups, int *order) {
+  int full = 1 << numGroups;
+  double *cost = (double *)malloc((size_t)full * numGroups * sizeof(double));
+  int *parent = (int *)malloc((size_t)full * numGroups * sizeof(int));
+  if (cost == NULL || parent == NULL) {
+    printf("Error: No se pudo asignar la tabla de secuencias en memoria.\n");
+    free(cost);
+    free(parent);
+    return -1;
+  }
+  for (int k = 0; k < full * numGroups; k++) {
+    cost[k] = DBL_MAX;
+    parent[k] = -1;
+  }
+  cost[1 * numGroups + 0] = 0;
+
+  for (int mask = 1; mask < full; mask += 2) { // Siempre contiene la fase 0
+    for (int last = 0; last < numGroups; last++) {
+      double current = cost[mask * numGroups + last];
+      if (current == DBL_MAX) {
+        continue;
+      }
+      for (int next = 1; next < numGroups; next++) {
+        if (mask & (1 << next)) {
+          continue;
+        }
+        int nextMask = mask | (1 << next);
+        double candidate = current + transition[last * numGroups + next];
+        if (candidate < cost[nextMask * numGroups + next]) {
+          cost[nextMask * numGroups + next] = candidate;
+          parent[nextMask * numGroups + next] = last;
+        }
+      }
+    }
+  }
+
+  // Cerrar el ciclo volviendo a la fase 0
+  int mask = full - 1;
+  int best = 0;
+  double bestCost = DBL_MAX;
+  for (int last = 1; last < numGroups; last++) {
+    double candidate =
+        cost[mask * numGroups + last] + transition[last * numGroups + 0];
+    if (candidate < bestCost) {
+      bestCost = candidate;
+      best = last;
+    }
+  }
+
+  for (int k = numGroups - 1; k > 0; k--) {
+    order[k] = best;
+    int previous = parent[mask * numGroups + best];
+    mask &= ~(1 << best);
+    best = previous;
+  }
+  order[0] = 0;
+
+  free(cost);
+  free(parent);
+  return bestCost;
+}
+
+/*
+ * Función: sequenceHeuristic
+ * Ordena las fases con vecino más cercano seguido de mejoras 2-opt y Or-opt.
+ *
+ * Descripción:
+ * Se construye un ciclo inicial eligiendo siempre la transición más barata y luego se aplican, mientras alguna
+ * mejore el ciclo, inversiones de segmentos (2-opt) y traslados de segmentos de 1 a 3 fases a otra posición
+ * (Or-opt). Como las transiciones no son simétricas, cada movimiento se evalúa recalculando el ciclo completo.
+ * Si se cancela, se deja de mejorar y queda el mejor orden encontrado hasta ese momento. Devuelve -1 si no hay
+ * memoria para el orden de trabajo.
+ */
+double sequenceHeuristic(double *transition, int numGroups, int *order,
+                         PlanningProgress *progress) {
+  bool *used = (bool *)calloc(numGroups, sizeof(bool));
+  int *candidate = (int *)malloc(numGroups * sizeof(int));
+  if (used == NULL || candidate == NULL) {
+    printf("Error: No se pudo asignar la secuencia en memoria.\n");
+    free(used);
+    free(candidate);
+    return -1;
+  }
+  order[0] = 0;
+  used[0] = true;
+  for (int k = 1; k < numGroups; k++) {
+    int best = -1;
+    for (int next = 0; next < numGroups; next++) {
+      if (!used[next] &&
+          (best == -1 || transition[order[k - 1] * numGroups + next] <
+                             transition[order[k - 1] * numGroups + best])) {
+        best = next;
+      }
+    }
+    order[k] = best;
+    used[best] = true;
+  }
+  free(used);
+
+  double bestCost = cycleLostTime(transition, numGroups, order);
+  bool improved = true;
+  while (improved && !planningCancelled(progress)) {
+    improved = false;
+
+    // 2-opt: invertir order[i..j]
+    for (int i = 1; i < numGroups - 1; i++) {
+      for (int j = i + 1; j < numGroups; j++) {
+        memcpy(candidate, order, numGroups * sizeof(int));
+        for (int a = i, b = j; a < b; a++, b--) {
+          int tmp = candidate[a];
+          candidate[a] = candidate[b];
+          candidate[b] = tmp;
+        }
+        double cost = cycleLostTime(transition, numGroups, candidate);
+        if (cost < bestCost - 1e-9) {
+          memcpy(order, candidate, numGroups * sizeof(int));
+          bestCost = cost;
+          improved = true;
+        }
+      }
+    }
+
+    // Or-opt: mover order[i..i+len-1] para que quede antes de la posición pos
+    for (int len = 1; len <= 3 && !planningCancelled(progress); len++) {
+      for (int i = 1; i + len <= numGroups; i++) {
+        for (int pos = 1; pos <= numGroups; pos++) {
+          if (pos >= i && pos <= i + len) {
+            continue;
+          }
+          int count = 0;
+          for (int k = 0; k < numGroups; k++) {
+            if (k == pos) {
+              for (int s = 0; s < len; s++) {
+                candidate[count++] = order[i + s];
+              }
+            }
+            if (k < i || k >= i + len) {
+              candidate[count++] = order[k];
+            }
+          }
+          if (pos == numGroups) {
+            for (int s = 0; s < len; s++) {
+              candidate[count++] = order[i + s];
+            }
+          }
+          double cost = cycleLostTime(transition, numGroups, candidate);
+          if (cost < bestCost - 1e-9) {
+            memcpy(order, candidate, numGroups * sizeof(int));
+            bestCost = cost;
+            improved = true;
+          }
+        }
+      }
+    }
+  }
+
+  free(candidate);
+  return bestCost;
+}
+
+/*
+ * Función: sequencePhases
+ * Calcula el orden de las fases que minimiza el tiempo perdido por ciclo.
+ *
+ * Parámetros:
+ * - transition: Matriz de transiciones de buildTransitionMatrix().
+ * - numGroups: Número de fases.
+ * - order: Arreglo de numGroups enteros donde se escribe la permutación resultante.
+ * - progress: Avance con la petición de cancelación, o NULL.
+ *
+ * Retorno:
+ * - Tiempo perdido por ciclo con el orden encontrado, exacto si numGroups <= MAX_EXACT_PHASES.
+ * - -1 si no se puede asignar memoria; el contenido de order queda indefinido.
+ */
+double sequencePhases(double *transition, int numGroups, int *order,
+                      PlanningProgress *progress) {
+  if (numGroups <= 2) {
+    for (int k = 0; k < numGroups; k++) {
+      order[k] = k;
+    }
+    return cycleLostTime(transition, numGroups, order);
+  }
+  if (numGroups <= MAX_EXACT_PHASES) {
+    return sequenceExact(transition, numGroups, order);
+  }
+  return sequenceHeuristic(transition, numGroups, order, progress);
+}
+
+/*
+ * Función: sequenceGroupList
+ * Reordena la lista de grupos para minimizar el tiempo perdido por despeje entre fases.
+ *
+ * Descripción:
+ * Calcula la matriz de transiciones entre fases, obtiene el mejor orden con sequencePhases() y vuelve a enlazar
+ * los grupos de la lista en ese orden.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo con los cruces y, opcionalmente, la matriz de despeje.
+ * - groupList: Lista de grupos que se reordenará.
+ * - progress: Avance con la petición de cancelación, o NULL.
+ *
+ * Retorno:
+ * - Tiempo perdido por ciclo en segundos con el nuevo orden.
+ * - -1 si no se puede asignar memoria; la lista queda en su orden original.
+ */
+double sequenceGroupList(Graph *graph, GroupList *groupList,
+                         PlanningProgress *progress) {
+  int numGroups = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    numGroups++;
+  }
+  if (numGroups == 0) {
+    return 0;
+  }
+
+  Group **groups = (Group **)malloc(numGroups * sizeof(Group *));
+  int *order = (int *)malloc(numGroups * sizeof(int));
+  double *transition = buildTransitionMatrix(graph, groupList, numGroups);
+  double lostTime = -1;
+  if (groups != NULL && order != NULL && transition != NULL) {
+    lostTime = sequencePhases(transition, numGroups, order, progress);
+  } else {
+    printf("Error: No se pudo asignar la secuencia en memoria.\n");
+  }
+  if (lostTime < 0) {
+    free(order);
+    free(transition);
+    free(groups);
+    return -1;
+  }
+
+  int k = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    groups[k++] = g;
+  }
+  groupList->head = groups[order[0]];
+  for (k = 0; k < numGroups - 1; k++) {
+    groups[order[k]]->next = groups[order[k + 1]];
+  }
+  groupList->tail = groups[order[numGroups - 1]];
+  groupList->tail->next = NULL;
+
+  free(order);
+  free(transition);
+  free(groups);
+  return lostTime;
+}
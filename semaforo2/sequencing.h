@@ -0,0 +1,33 @@
+#ifndef SEQUENCING_H
+#define SEQUENCING_H
+
+#include "conflicts.h"
+#include "graph.h"
+#include <stdint.h>
+#include "traffic_lights.h"
+
+// Despeje por defecto (ámbar + todo rojo, en segundos) entre dos cruces
+// incompatibles cuando el archivo de entrada no lo especifica
+#define DEFAULT_CLEARANCE 4.0
+
+// Número máximo de fases para ordenar de forma exacta (programación dinámica
+// sobre subconjuntos); con más fases se usa la heurística 2-opt/Or-opt
+#define MAX_EXACT_PHASES 12
+
+// Funciones a implementar en sequencing.c
+double getClearance(Graph *graph, ConflictMatrix *conflicts, int from,
+                    int to);
+double *buildTransitionMatrix(Graph *graph, GroupList *groupList,
+                              int numGroups);
+double maskTransition(Graph *graph, ConflictMatrix *conflicts, uint64_t from,
+                      uint64_t to);
+double cycleLostTime(double *transition, int numGroups, int *order);
+double sequenceExact(double *transition, int numGroups, int *order);
+double sequenceHeuristic(double *transition, int numGroups, int *order,
+                         PlanningProgress *progress);
+double sequencePhases(double *transition, int numGroups, int *order,
+                      PlanningProgress *progress);
+double sequenceGroupList(Graph *graph, GroupList *groupList,
+                         PlanningProgress *progress);
+
+#endif
@@ -0,0 +1,136 @@
+#include "sequencing.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Prueba del ordenamiento de fases: en instancias pequeñas la programación
+// dinámica (Held-Karp) debe dar el mismo tiempo perdido que probar todas las
+// permutaciones, y la heurística 2-opt/Or-opt nunca puede mejorar el óptimo.
+// Se usa con `make test`.
+#define TEST_MIN_PHASES 3
+#define TEST_MAX_PHASES 9
+#define TEST_INSTANCES 200
+
+/*
+ * Función: nextRandom
+ * Siguiente valor de una secuencia xorshift64; la misma semilla da la misma secuencia.
+ */
+static uint64_t nextRandom(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/*
+ * Función: randomTransitions
+ * Llena una matriz de transiciones no simétrica con despejes de 0 a 6 s en pasos de medio segundo.
+ */
+static void randomTransitions(double *transition, int numGroups,
+                              uint64_t *seed) {
+  for (int a = 0; a < numGroups; a++) {
+    for (int b = 0; b < numGroups; b++) {
+      transition[a * numGroups + b] =
+          a == b ? 0 : (double)(nextRandom(seed) % 13) / 2;
+    }
+  }
+}
+
+/*
+ * Función: bruteForce
+ * Prueba todas las permutaciones con la fase 0 primero y devuelve el menor tiempo perdido.
+ */
+static double bruteForce(double *transition, int numGroups, int *order,
+                         int depth, bool *used) {
+  if (depth == numGroups) {
+    return cycleLostTime(transition, numGroups, order);
+  }
+  double best = INFINITY;
+  for (int next = 1; next < numGroups; next++) {
+    if (used[next]) {
+      continue;
+    }
+    used[next] = true;
+    order[depth] = next;
+    double cost = bruteForce(transition, numGroups, order, depth + 1, used);
+    if (cost < best) {
+      best = cost;
+    }
+    used[next] = false;
+  }
+  return best;
+}
+
+/*
+ * Función: isPermutation
+ * Indica si el orden contiene cada fase una sola vez y comienza por la fase 0.
+ */
+static bool isPermutation(const int *order, int numGroups) {
+  bool seen[TEST_MAX_PHASES] = {false};
+  for (int k = 0; k < numGroups; k++) {
+    if (order[k] < 0 || order[k] >= numGroups || seen[order[k]]) {
+      return false;
+    }
+    seen[order[k]] = true;
+  }
+  return order[0] == 0;
+}
+
+int main(void) {
+  uint64_t seed = 0x2545f4914f6cdd1dull;
+  double transition[TEST_MAX_PHASES * TEST_MAX_PHASES];
+  int order[TEST_MAX_PHASES];
+  bool used[TEST_MAX_PHASES];
+  int errors = 0, instances = 0, matched = 0;
+  double worstGap = 0;
+
+  for (int n = TEST_MIN_PHASES; n <= TEST_MAX_PHASES; n++) {
+    for (int t = 0; t < TEST_INSTANCES; t++) {
+      randomTransitions(transition, n, &seed);
+      instances++;
+
+      memset(used, 0, sizeof(used));
+      order[0] = 0;
+      double optimum = bruteForce(transition, n, order, 1, used);
+
+      double exact = sequenceExact(transition, n, order);
+      if (!isPermutation(order, n) ||
+          fabs(exact - cycleLostTime(transition, n, order)) > 1e-9) {
+        printf("Error: Held-Karp devolvio un orden invalido con %d fases.\n",
+               n);
+        errors++;
+      } else if (fabs(exact - optimum) > 1e-9) {
+        printf("Error: Held-Karp dio %.1f s y el optimo es %.1f s con %d "
+               "fases.\n",
+               exact, optimum, n);
+        errors++;
+      }
+
+      double heuristic = sequenceHeuristic(transition, n, order, NULL);
+      if (!isPermutation(order, n) ||
+          fabs(heuristic - cycleLostTime(transition, n, order)) > 1e-9) {
+        printf("Error: La heuristica devolvio un orden invalido con %d "
+               "fases.\n",
+               n);
+        errors++;
+      } else if (heuristic < optimum - 1e-9) {
+        printf("Error: La heuristica dio %.1f s, menos que el optimo %.1f s.\n",
+               heuristic, optimum);
+        errors++;
+      } else {
+        matched += heuristic <= optimum + 1e-9;
+        if (heuristic - optimum > worstGap) {
+          worstGap = heuristic - optimum;
+        }
+      }
+    }
+  }
+
+  printf("sequencing_test: %d instancias, la heuristica alcanzo el optimo en "
+         "%d (peor diferencia %.1f s), %d errores\n",
+         instances, matched, worstGap, errors);
+  return errors == 0 ? 0 : 1;
+}
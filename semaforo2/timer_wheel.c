@@ -0,0 +1,165 @@
+#include "timer_wheel.h"
+#include "controller.h"
+
+#include <stddef.h>
+
+static inline void listInit(TimerNode *head) {
+  head->next = head;
+  head->prev = head;
+}
+
+static inline void listAppend(TimerNode *head, TimerNode *timer) {
+  timer->prev = head->prev;
+  timer->next = head;
+  head->prev->next = timer;
+  head->prev = timer;
+}
+
+static inline void listUnlink(TimerNode *timer) {
+  timer->prev->next = timer->next;
+  timer->next->prev = timer->prev;
+  timer->next = NULL;
+  timer->prev = NULL;
+}
+
+/*
+ * Función: timerWheelInit
+ * Inicializa una rueda vacía cuyo último tick procesado es `now`.
+ */
+void timerWheelInit(TimerWheel *wheel, uint64_t now) {
+  wheel->now = now;
+  wheel->pending = 0;
+  for (int level = 0; level < WHEEL_LEVELS; level++) {
+    for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+      listInit(&wheel->slots[level][slot]);
+    }
+  }
+}
+
+/*
+ * Función: placeTimer
+ * Coloca un temporizador en la ranura que le corresponde según cuánto falta para que venza.
+ */
+static void placeTimer(TimerWheel *wheel, TimerNode *timer) {
+  uint64_t expires = timer->expires;
+  uint64_t delta = expires - wheel->now;
+  int level = 0;
+  while (level < WHEEL_LEVELS - 1 &&
+         delta >= (uint64_t)1 << (WHEEL_BITS * (level + 1))) {
+    level++;
+  }
+  if (level == WHEEL_LEVELS - 1 &&
+      delta >= (uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) {
+    // Fuera del alcance: se acerca al límite y se recoloca al redistribuir
+    expires = wheel->now + ((uint64_t)1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+  }
+  int slot = (int)((expires >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+  listAppend(&wheel->slots[level][slot], timer);
+}
+
+/*
+ * Función: timerWheelAdd
+ * Programa un temporizador para el tick `expires`.
+ *
+ * Descripción:
+ * Un temporizador vencido o para el tick actual se programa para el siguiente tick. El temporizador no debe estar
+ * programado.
+ *
+ * Parámetros:
+ * - wheel: Rueda de tiempo.
+ * - timer: Temporizador (dentro de la estructura que lo usa).
+ * - expires: Tick en que vence.
+ *
+ * Retorno: Ninguno.
+ */
+void timerWheelAdd(TimerWheel *wheel, TimerNode *timer, uint64_t expires) {
+  timer->expires = expires > wheel->now ? expires : wheel->now + 1;
+  placeTimer(wheel, timer);
+  wheel->pending++;
+}
+
+/*
+ * Función: timerWheelRemove
+ * Cancela un temporizador programado; si no está programado no se hace nada.
+ */
+void timerWheelRemove(TimerWheel *wheel, TimerNode *timer) {
+  if (timer->next != NULL) {
+    listUnlink(timer);
+    wheel->pending--;
+  }
+}
+
+/*
+ * Función: cascade
+ * Redistribuye en niveles inferiores los temporizadores de la ranura actual de un nivel.
+ *
+ * Retorno:
+ * - true si la ranura del nivel también dio la vuelta y hay que redistribuir el nivel siguiente.
+ */
+static int cascade(TimerWheel *wheel, int level) {
+  int slot =
+      (int)((wheel->now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1));
+  TimerNode *head = &wheel->slots[level][slot];
+  TimerNode pending;
+  listInit(&pending);
+  if (head->next != head) {
+    pending.next = head->next;
+    pending.prev = head->prev;
+    pending.next->prev = &pending;
+    pending.prev->next = &pending;
+    listInit(head);
+  }
+  while (pending.next != &pending) {
+    TimerNode *timer = pending.next;
+    listUnlink(timer);
+    placeTimer(wheel, timer);
+  }
+  return slot == 0;
+}
+
+/*
+ * Función: timerWheelAdvance
+ * Avanza la rueda tick por tick hasta `now` y llama a `callback` con cada temporizador vencido.
+ *
+ * Descripción:
+ * El temporizador se saca de la rueda antes de llamar a `callback`, que puede volver a programarlo (por ejemplo,
+ * para el siguiente cambio de fase). Los temporizadores que vencen en un mismo tick se entregan en el orden en que
+ * se programaron.
+ *
+ * Parámetros:
+ * - wheel: Rueda de tiempo.
+ * - now: Tick hasta el que se avanza.
+ * - callback: Función para cada temporizador vencido.
+ * - context: Dato que se pasa a `callback`.
+ *
+ * Retorno:
+ * - Número de temporizadores vencidos.
+ */
+int timerWheelAdvance(TimerWheel *wheel, uint64_t now, TimerCallback callback,
+                      void *context) {
+  int fired = 0;
+  while (wheel->now < now) {
+    wheel->now++;
+    int slot = (int)(wheel->now & (WHEEL_SLOTS - 1));
+    if (slot == 0) {
+      for (int level = 1; level < WHEEL_LEVELS && cascade(wheel, level);
+           level++) {
+      }
+    }
+
+    TimerNode *head = &wheel->slots[0][slot];
+    while (head->next != head) {
+      TimerNode *timer = head->next;
+      listUnlink(timer);
+      wheel->pending--;
+      if (timer->expires > wheel->now) {
+        placeTimer(wheel, timer); // Venía recortado del nivel superior
+        wheel->pending++;
+        continue;
+      }
+      callback(timer, wheel->now, context);
+      fired++;
+    }
+  }
+  return fired;
+}
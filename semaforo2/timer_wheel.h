@@ -0,0 +1,32 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "controller.h"
+#include <stdint.h>
+
+// Rueda de tiempo jerárquica: el nivel L tiene 64 ranuras de 64^L ticks, de
+// modo que 4 niveles cubren 64^4 ticks (19 días con ticks de 100 ms).
+// Programar o cancelar un temporizador es O(1) y avanzar un tick cuesta lo
+// que vence en él, más la redistribución ocasional de una ranura de un nivel
+// superior.
+#define WHEEL_LEVELS 4
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+
+typedef struct TimerWheel {
+  uint64_t now; // Último tick procesado
+  int pending;  // Temporizadores programados
+  TimerNode slots[WHEEL_LEVELS][WHEEL_SLOTS]; // Centinelas de listas circulares
+} TimerWheel;
+
+// Se llama con cada temporizador vencido, ya fuera de la rueda
+typedef void (*TimerCallback)(TimerNode *timer, uint64_t now, void *context);
+
+// Funciones a implementar en timer_wheel.c
+void timerWheelInit(TimerWheel *wheel, uint64_t now);
+void timerWheelAdd(TimerWheel *wheel, TimerNode *timer, uint64_t expires);
+void timerWheelRemove(TimerWheel *wheel, TimerNode *timer);
+int timerWheelAdvance(TimerWheel *wheel, uint64_t now, TimerCallback callback,
+                      void *context);
+
+#endif
@@ -0,0 +1,161 @@
+#include "timer_wheel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Prueba de la rueda de tiempo contra un calendario por fuerza bruta: cada
+// temporizador guarda el tick en que debe vencer y se comprueba que la rueda
+// lo entregue exactamente en ese tick, una sola vez. Se usa con `make test`.
+#define TEST_TIMERS 4096
+#define TEST_ROUNDS 64
+#define TEST_MAX_DELAY ((uint64_t)1 << 25) // Más allá del alcance de la rueda
+
+typedef struct TestTimer {
+  TimerNode node; // Primer miembro, como en Controller
+  uint64_t due;   // Tick esperado; 0 si no está programado
+} TestTimer;
+
+typedef struct TestState {
+  TimerWheel *wheel;
+  TestTimer *timers;
+  uint64_t seed;
+  int errors;
+  int fired;
+  int drain; // Sin reprogramar desde el callback
+} TestState;
+
+/*
+ * Función: nextRandom
+ * Siguiente valor de una secuencia xorshift64; la misma semilla da la misma secuencia.
+ */
+static uint64_t nextRandom(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/*
+ * Función: randomDelay
+ * Retardo con escala variada para ejercitar todos los niveles de la rueda y el recorte de los lejanos.
+ */
+static uint64_t randomDelay(uint64_t *state) {
+  int bits = (int)(nextRandom(state) % 26);
+  return nextRandom(state) & (((uint64_t)1 << bits) - 1) & (TEST_MAX_DELAY - 1);
+}
+
+/*
+ * Función: schedule
+ * Programa un temporizador en la rueda y anota en el calendario el tick en que debe vencer.
+ */
+static void schedule(TimerWheel *wheel, TestTimer *timer, uint64_t expires) {
+  timerWheelAdd(wheel, &timer->node, expires);
+  timer->due = expires > wheel->now ? expires : wheel->now + 1;
+}
+
+/*
+ * Función: fireTest
+ * Comprueba un temporizador vencido contra el calendario y a veces lo vuelve a programar desde el callback.
+ */
+static void fireTest(TimerNode *node, uint64_t now, void *context) {
+  TestState *state = (TestState *)context;
+  TestTimer *timer = (TestTimer *)node;
+  if (timer->due != now) {
+    printf("Error: Temporizador %d vencio en %lu y debia vencer en %lu.\n",
+           (int)(timer - state->timers), (unsigned long)now,
+           (unsigned long)timer->due);
+    state->errors++;
+  }
+  timer->due = 0;
+  state->fired++;
+  if (!state->drain && nextRandom(&state->seed) % 4 == 0) {
+    schedule(state->wheel, timer, now + randomDelay(&state->seed));
+  }
+}
+
+int main(void) {
+  TimerWheel *wheel = (TimerWheel *)malloc(sizeof(TimerWheel));
+  TestTimer *timers = (TestTimer *)calloc(TEST_TIMERS, sizeof(TestTimer));
+  if (wheel == NULL || timers == NULL) {
+    printf("Error: No se pudo asignar la prueba en memoria.\n");
+    free(wheel);
+    free(timers);
+    return 1;
+  }
+  TestState state = {wheel, timers, 0x9e3779b97f4a7c15ull, 0, 0, 0};
+  uint64_t start = 1000;
+  timerWheelInit(wheel, start);
+
+  int scheduled = 0;
+  for (int round = 0; round < TEST_ROUNDS && state.errors == 0; round++) {
+    // Programa los libres y cancela o reprograma algunos de los pendientes
+    for (int i = 0; i < TEST_TIMERS; i++) {
+      TestTimer *timer = &timers[i];
+      uint64_t choice = nextRandom(&state.seed) % 8;
+      if (timer->due == 0 && choice < 6) {
+        schedule(wheel, timer, wheel->now + randomDelay(&state.seed));
+        scheduled++;
+      } else if (timer->due != 0 && choice == 0) {
+        timerWheelRemove(wheel, &timer->node);
+        timer->due = 0;
+      } else if (timer->due != 0 && choice == 1) {
+        timerWheelRemove(wheel, &timer->node);
+        schedule(wheel, timer, wheel->now + randomDelay(&state.seed));
+        scheduled++;
+      }
+    }
+
+    int pending = 0;
+    uint64_t first = UINT64_MAX;
+    for (int i = 0; i < TEST_TIMERS; i++) {
+      if (timers[i].due != 0) {
+        pending++;
+        if (timers[i].due < first) {
+          first = timers[i].due;
+        }
+      }
+    }
+    if (wheel->pending != pending) {
+      printf("Error: La rueda tiene %d temporizadores y el calendario %d.\n",
+             wheel->pending, pending);
+      state.errors++;
+      break;
+    }
+
+    // Avanza a saltos de distinta longitud, a veces justo hasta el primero
+    uint64_t target = nextRandom(&state.seed) % 2 == 0 && first != UINT64_MAX
+                          ? first
+                          : wheel->now + randomDelay(&state.seed) + 1;
+    timerWheelAdvance(wheel, target, fireTest, &state);
+    for (int i = 0; i < TEST_TIMERS; i++) {
+      if (timers[i].due != 0 && timers[i].due <= target) {
+        printf("Error: Temporizador %d no vencio en %lu.\n", i,
+               (unsigned long)timers[i].due);
+        state.errors++;
+      }
+    }
+  }
+
+  // Al final tienen que vencer todos los pendientes, sin reprogramarlos
+  state.drain = 1;
+  uint64_t last = wheel->now;
+  for (int i = 0; i < TEST_TIMERS; i++) {
+    if (timers[i].due > last) {
+      last = timers[i].due;
+    }
+  }
+  timerWheelAdvance(wheel, last, fireTest, &state);
+  if (wheel->pending != 0) {
+    printf("Error: Quedaron %d temporizadores en la rueda.\n", wheel->pending);
+    state.errors++;
+  }
+
+  printf("timer_wheel_test: %d temporizadores programados, %d vencidos en %lu "
+         "ticks, %d errores\n",
+         scheduled, state.fired, (unsigned long)(wheel->now - start),
+         state.errors);
+  free(timers);
+  free(wheel);
+  return state.errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int traceEnabled = 0;
+_Thread_local TraceBuffer *traceBuffer = NULL;
+
+// Lista de los búferes de todos los hilos, para volcarlos juntos
+static TraceBuffer *traceBuffers = NULL;
+static uint32_t traceNumThreads = 0;
+static pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Clave por hilo cuyo destructor devuelve el búfer a la lista al terminar
+static pthread_key_t traceKey;
+static pthread_once_t traceKeyOnce = PTHREAD_ONCE_INIT;
+
+static const char *traceFilename = NULL;
+static uint64_t traceStartTicks, traceStartNs;
+
+static uint64_t monotonicNs(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/*
+ * Función: traceReleaseThread
+ * Marca como libre el búfer de un hilo que terminó, para que lo reutilice el siguiente hilo que se registre.
+ */
+static void traceReleaseThread(void *buffer) {
+  pthread_mutex_lock(&traceLock);
+  ((TraceBuffer *)buffer)->inUse = 0;
+  pthread_mutex_unlock(&traceLock);
+}
+
+static void traceCreateKey(void) {
+  pthread_key_create(&traceKey, traceReleaseThread);
+}
+
+/*
+ * Función: traceRegisterThread
+ * Asigna un búfer al hilo actual: uno libre de la lista global o, si no hay, uno nuevo.
+ *
+ * Descripción:
+ * Se llama una sola vez por hilo, la primera vez que registra un evento. Es el único punto que toma un bloqueo.
+ * Los búferes no se liberan al terminar el hilo porque sus eventos se vuelcan al salir del programa; en cambio el
+ * siguiente hilo continúa el mismo búfer circular con el mismo identificador, de modo que crear y terminar hilos
+ * de planificación una y otra vez no agrega un búfer por hilo.
+ *
+ * Retorno:
+ * - Puntero al búfer del hilo.
+ */
+TraceBuffer *traceRegisterThread(void) {
+  pthread_once(&traceKeyOnce, traceCreateKey);
+  pthread_mutex_lock(&traceLock);
+  TraceBuffer *buffer = traceBuffers;
+  while (buffer != NULL && buffer->inUse) {
+    buffer = buffer->nextBuffer;
+  }
+  if (buffer == NULL) {
+    buffer = (TraceBuffer *)calloc(1, sizeof(TraceBuffer));
+    if (buffer == NULL) {
+      pthread_mutex_unlock(&traceLock);
+      printf("Error: No se pudo asignar el bufer de traza en memoria.\n");
+      exit(1);
+    }
+    buffer->threadId = ++traceNumThreads;
+    buffer->nextBuffer = traceBuffers;
+    traceBuffers = buffer;
+  }
+  buffer->inUse = 1;
+  pthread_mutex_unlock(&traceLock);
+
+  pthread_setspecific(traceKey, buffer);
+  traceBuffer = buffer;
+  return buffer;
+}
+
+/*
+ * Función: traceAtExit
+ * Vuelca la traza al archivo indicado en traceStart() cuando termina el programa.
+ */
+static void traceAtExit(void) {
+  if (traceFilename != NULL && traceDump(traceFilename) != 0) {
+    printf("Error: No se pudo escribir la traza.\n");
+  }
+}
+
+/*
+ * Función: traceStart
+ * Activa el registro de eventos y programa el volcado al terminar el programa.
+ *
+ * Parámetros:
+ * - filename: Archivo binario donde se escribirá la traza.
+ *
+ * Retorno:
+ * - 0 si la traza quedó activa.
+ */
+int traceStart(const char *filename) {
+  traceFilename = filename;
+  traceStartTicks = traceTimestamp();
+  traceStartNs = monotonicNs();
+  traceEnabled = 1;
+  atexit(traceAtExit);
+  return 0;
+}
+
+/*
+ * Función: traceDump
+ * Escribe los eventos de todos los hilos en un archivo binario.
+ *
+ * Descripción:
+ * Los hilos que registran eventos no se detienen, por lo que el volcado debe hacerse cuando ya terminaron (por
+ * ejemplo después de pthread_join() o al salir del programa). Si un búfer dio la vuelta, solo se escriben los
+ * últimos TRACE_CAPACITY eventos y el resto se informa como descartado.
+ *
+ * Parámetros:
+ * - filename: Archivo de salida.
+ *
+ * Retorno:
+ * - 0 si el archivo se escribió correctamente.
+ * - -1 si no se pudo abrir o escribir.
+ */
+int traceDump(const char *filename) {
+  FILE *file = fopen(filename, "wb");
+  if (file == NULL) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&traceLock);
+  TraceFileHeader header = {0};
+  header.magic = TRACE_MAGIC;
+  header.version = TRACE_VERSION;
+  header.numThreads = traceNumThreads;
+  header.startTicks = traceStartTicks;
+  header.startNs = traceStartNs;
+  header.endTicks = traceTimestamp();
+  header.endNs = monotonicNs();
+  int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+  for (TraceBuffer *buffer = traceBuffers; buffer != NULL && ok;
+       buffer = buffer->nextBuffer) {
+    uint64_t head = buffer->head;
+    TraceThreadHeader thread;
+    thread.threadId = buffer->threadId;
+    thread.count = head < TRACE_CAPACITY ? (uint32_t)head : TRACE_CAPACITY;
+    thread.dropped = head - thread.count;
+    ok = fwrite(&thread, sizeof(thread), 1, file) == 1;
+    for (uint64_t k = head - thread.count; k < head && ok; k++) {
+      ok = fwrite(&buffer->events[k & (TRACE_CAPACITY - 1)],
+                  sizeof(TraceEvent), 1, file) == 1;
+    }
+  }
+  pthread_mutex_unlock(&traceLock);
+
+  if (fclose(file) != 0) {
+    ok = 0;
+  }
+  return ok ? 0 : -1;
+}
@@ -0,0 +1,103 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Eventos de 16 bytes en un búfer circular por hilo. Registrar un evento es
+// leer el contador de ciclos y escribir en memoria del propio hilo, sin
+// llamadas al sistema ni bloqueos.
+#define TRACE_CAPACITY 4096 // Eventos por hilo, potencia de 2
+#define TRACE_MAGIC 0x52544d53 // "SMTR"
+#define TRACE_VERSION 1
+
+typedef enum TraceEventType {
+  TRACE_STAGE_BEGIN = 1, // arg0 = TraceStage
+  TRACE_STAGE_END,       // arg0 = TraceStage
+  TRACE_PHASE_START,     // arg0 = fase, arg1 = intersección
+  TRACE_PHASE_END,       // arg0 = fase, arg1 = intersección
+  TRACE_DETECTOR         // arg0 = cruce, arg1 = intersección
+} TraceEventType;
+
+typedef enum TraceStage {
+  STAGE_GROUPING,
+  STAGE_OVERLAP,
+  STAGE_SEQUENCING,
+  STAGE_TIMING,
+  STAGE_PREEMPTION,
+  STAGE_LIBRARY,
+  NUM_TRACE_STAGES
+} TraceStage;
+
+typedef struct TraceEvent {
+  uint64_t timestamp; // Ciclos del TSC, o ns de CLOCK_MONOTONIC sin TSC
+  uint16_t type;
+  uint16_t arg0;
+  uint32_t arg1;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+  uint64_t head; // Eventos escritos desde el inicio (también los sobrescritos)
+  uint32_t threadId;
+  uint32_t inUse; // 0 si el hilo que lo usaba terminó y puede reutilizarse
+  struct TraceBuffer *nextBuffer;
+  TraceEvent events[TRACE_CAPACITY];
+} TraceBuffer;
+
+// Formato del archivo: TraceFileHeader, luego por cada hilo un
+// TraceThreadHeader seguido de sus `count` eventos del más antiguo al más
+// reciente. Los pares (ticks, ns) permiten convertir marcas de tiempo a ns.
+typedef struct TraceFileHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t numThreads;
+  uint32_t reserved;
+  uint64_t startTicks, startNs;
+  uint64_t endTicks, endNs;
+} TraceFileHeader;
+
+typedef struct TraceThreadHeader {
+  uint32_t threadId;
+  uint32_t count;
+  uint64_t dropped; // Eventos sobrescritos por el búfer circular
+} TraceThreadHeader;
+
+extern int traceEnabled;
+extern _Thread_local TraceBuffer *traceBuffer;
+
+static inline uint64_t traceTimestamp(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+#endif
+}
+
+// Funciones a implementar en trace.c
+TraceBuffer *traceRegisterThread(void);
+int traceStart(const char *filename);
+int traceDump(const char *filename);
+
+static inline void traceEvent(TraceEventType type, uint16_t arg0,
+                              uint32_t arg1) {
+  if (!traceEnabled) {
+    return;
+  }
+  TraceBuffer *buffer = traceBuffer;
+  if (buffer == NULL) {
+    buffer = traceRegisterThread();
+  }
+  TraceEvent *event = &buffer->events[buffer->head & (TRACE_CAPACITY - 1)];
+  event->timestamp = traceTimestamp();
+  event->type = (uint16_t)type;
+  event->arg0 = arg0;
+  event->arg1 = arg1;
+  buffer->head++;
+}
+
+#endif
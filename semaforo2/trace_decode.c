@@ -0,0 +1,136 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Decodificador fuera de línea: convierte un volcado de trace.c al formato
+// JSON de Chrome (chrome://tracing o Perfetto).
+
+static const char *stageNames[NUM_TRACE_STAGES] = {
+    "agrupacion", "traslape", "secuencia", "temporizacion", "preferencia",
+    "biblioteca"};
+
+/*
+ * Función: ticksToMicroseconds
+ * Convierte una marca de tiempo del volcado a microsegundos desde el inicio de la traza.
+ *
+ * Descripción:
+ * Usa la recta que pasa por los pares (ticks, ns) tomados al iniciar y al volcar la traza.
+ */
+static double ticksToMicroseconds(TraceFileHeader *header, uint64_t ticks) {
+  double ticksPerNs = 1.0;
+  if (header->endTicks > header->startTicks &&
+      header->endNs > header->startNs) {
+    ticksPerNs = (double)(header->endTicks - header->startTicks) /
+                 (double)(header->endNs - header->startNs);
+  }
+  return ((double)ticks - (double)header->startTicks) / ticksPerNs / 1000.0;
+}
+
+/*
+ * Función: writeEvent
+ * Escribe un evento como objeto JSON de Chrome.
+ *
+ * Descripción:
+ * Las etapas de planificación se muestran en el proceso 1 con un carril por hilo; las fases y detectores en el
+ * proceso 2 con un carril por intersección.
+ */
+static void writeEvent(FILE *out, TraceFileHeader *header, uint32_t threadId,
+                       TraceEvent *event, int first) {
+  double ts = ticksToMicroseconds(header, event->timestamp);
+  if (!first) {
+    fprintf(out, ",\n");
+  }
+  switch (event->type) {
+  case TRACE_STAGE_BEGIN:
+  case TRACE_STAGE_END:
+    fprintf(out,
+            "{\"name\":\"%s\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+            event->arg0 < NUM_TRACE_STAGES ? stageNames[event->arg0] : "?",
+            event->type == TRACE_STAGE_BEGIN ? "B" : "E", ts, threadId);
+    break;
+  case TRACE_PHASE_START:
+  case TRACE_PHASE_END:
+    fprintf(out,
+            "{\"name\":\"Fase %u\",\"ph\":\"%s\",\"ts\":%.3f,\"pid\":2,"
+            "\"tid\":%u}",
+            event->arg0 + 1, event->type == TRACE_PHASE_START ? "B" : "E", ts,
+            event->arg1);
+    break;
+  case TRACE_DETECTOR:
+    fprintf(out,
+            "{\"name\":\"Detector %u\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+            "\"pid\":2,\"tid\":%u}",
+            event->arg0, ts, event->arg1);
+    break;
+  default:
+    fprintf(out,
+            "{\"name\":\"Evento %u\",\"ph\":\"i\",\"ts\":%.3f,\"pid\":1,"
+            "\"tid\":%u}",
+            event->type, ts, threadId);
+    break;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    printf("Uso: %s TRAZA.bin SALIDA.json\n", argv[0]);
+    return 1;
+  }
+  FILE *in = fopen(argv[1], "rb");
+  if (in == NULL) {
+    printf("Error: No se pudo abrir el archivo de traza.\n");
+    return 1;
+  }
+
+  TraceFileHeader header;
+  if (fread(&header, sizeof(header), 1, in) != 1 ||
+      header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+    printf("Error: El archivo no es una traza valida.\n");
+    fclose(in);
+    return 1;
+  }
+
+  FILE *out = fopen(argv[2], "w");
+  if (out == NULL) {
+    printf("Error: No se pudo crear el archivo de salida.\n");
+    fclose(in);
+    return 1;
+  }
+
+  fprintf(out, "{\"traceEvents\":[\n");
+  int first = 1;
+  uint64_t total = 0, dropped = 0;
+  int truncated = 0;
+  // Tras una lectura incompleta el resto del archivo ya no está alineado con
+  // las cabeceras, así que se deja de decodificar por completo
+  for (uint32_t t = 0; t < header.numThreads && !truncated; t++) {
+    TraceThreadHeader thread;
+    if (fread(&thread, sizeof(thread), 1, in) != 1) {
+      truncated = 1;
+      break;
+    }
+    dropped += thread.dropped;
+    for (uint32_t k = 0; k < thread.count; k++) {
+      TraceEvent event;
+      if (fread(&event, sizeof(event), 1, in) != 1) {
+        truncated = 1;
+        break;
+      }
+      writeEvent(out, &header, thread.threadId, &event, first);
+      first = 0;
+      total++;
+    }
+  }
+  fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+  if (truncated) {
+    printf("Aviso: Traza truncada.\n");
+  }
+
+  fclose(out);
+  fclose(in);
+  printf("%llu eventos de %u hilos (%llu descartados).\n",
+         (unsigned long long)total, header.numThreads,
+         (unsigned long long)dropped);
+  return 0;
+}
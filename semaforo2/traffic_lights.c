@@ -2,6 +2,10 @@
 #include "user_interface.h"
 
 #include "traffic_lights.h"
+#include "overlap.h"
+#include "sequencing.h"
+#include "trace.h"
+#include "weighted_grouping.h"
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -135,6 +139,29 @@ bool isPartOfQueue(Queue *queue, Node *node) {
 }
 
 
+/*
+ * Función: freeQueue
+ * Libera la cola y todos sus nodos.
+ *
+ * Descripción:
+ * Esta función recorre la cola desde el frente (front) liberando cada nodo de cola y al final libera la estructura
+ * de la cola. Los nodos del grafo a los que apuntan los nodos de cola no se liberan.
+ *
+ * Parámetros:
+ * - queue: Puntero a la cola que se liberará.
+ *
+ * Retorno: Ninguno.
+ */
+void freeQueue(Queue *queue) {
+  QueueNode *current = queue->front;
+  while (current != NULL) {
+    QueueNode *next = current->next;
+    free(current);
+    current = next;
+  }
+  free(queue);
+}
+
 /*
  * Función: createNewGroup
  * Crea un nuevo grupo.
@@ -263,37 +290,65 @@ void printGroupList(GroupList *groupList) {
 }
 
 /*
-    Función: createGroups
-    Crea grupos de vértices en el grafo.
-    Descripción:
-    Esta función crea grupos de vértices en el grafo utilizando un algoritmo de
-   búsqueda y asignación de nodos. Inicialmente, se crea una lista de grupos
-   vacía. Luego, se itera hasta que todos los vértices hayan sido agregados a
-   los grupos o hasta que se haya recorrido todos los nodos del grafo. Durante
-   cada iteración, se crea un arreglo dinámico de nodos llamado "groupNodes"
-   para almacenar los nombres de los vértices que serán parte de un grupo. Se
-   inicializa un contador de nodos agregados ("groupNodesCount") y se crea una
-   cola de nodos incompatibles
-    ("incompatibleNodes"). A continuación, se recorren los vértices restantes en
-   el grafo a partir del último nodo buscado ("searchedNodes"). Si un vértice ya
-   se encuentra en un grupo existente, se omite y se pasa a la siguiente
-    iteración. De lo contrario, se agrega el vértice al grupo actual si no está
-   en la cola de nodos incompatibles, incrementando el contador de nodos
-   agregados. Luego, se agregan los nodos adyacentes al vértice actual a la cola
-    de nodos incompatibles. Después de procesar todos los vértices restantes, se
-   guarda el grupo actual en la lista de grupos. El proceso continúa hasta que
-   se hayan agregado todos los vértices al menos una vez, o hasta que se haya
-   recorrido todos los nodos del grafo. Finalmente, se imprime la lista de
-   grupos y se liberan los recursos utilizados por los grupos y el grafo.
-    Parámetros:
-        graph: Puntero al grafo en el que se crearán los grupos.
-    Retorno: Ninguno.
-    */
-void createGroups(Graph *graph) {
+ * Función: conflictsWithGroup
+ * Verifica si un vértice es incompatible con alguno de los nodos de un grupo en construcción.
+ *
+ * Descripción:
+ * El archivo de entrada puede listar una incompatibilidad en un solo sentido (A - B sin B - A), así que se revisan
+ * ambos sentidos con isEdge().
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - groupNodes: Nombres de los nodos del grupo.
+ * - groupNodesCount: Número de nodos del grupo.
+ * - name: Nombre del vértice a revisar.
+ *
+ * Retorno:
+ * - true si el vértice es incompatible con algún nodo del grupo.
+ * - false en caso contrario.
+ */
+static bool conflictsWithGroup(Graph *graph, char **groupNodes,
+                               int groupNodesCount, char *name) {
+  for (int k = 0; k < groupNodesCount; k++) {
+    if (isEdge(graph, groupNodes[k], name) || isEdge(graph, name, groupNodes[k])) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  GroupList groupList;
-  groupList.head = NULL;
-  groupList.tail = NULL;
+/*
+ * Función: buildGroupList
+ * Construye la lista de grupos (fases) de vértices compatibles del grafo.
+ *
+ * Descripción:
+ * Esta función crea grupos de vértices en el grafo utilizando un algoritmo de búsqueda y asignación de nodos.
+ * Se itera hasta que todos los vértices hayan sido agregados a los grupos o hasta que se haya recorrido todos los
+ * nodos del grafo. Durante cada iteración, se crea un arreglo dinámico de nodos llamado "groupNodes" para almacenar
+ * los nombres de los vértices que serán parte de un grupo y una cola de nodos incompatibles ("incompatibleNodes").
+ * A continuación, se recorren los vértices restantes en el grafo a partir del último nodo buscado
+ * ("searchedNodes"). Si un vértice ya se encuentra en un grupo existente, se omite. De lo contrario, se agrega el
+ * vértice al grupo actual si no está en la cola de nodos incompatibles ni es incompatible, en cualquiera de los dos
+ * sentidos, con los nodos que ya tiene el grupo (conflictsWithGroup()). Luego, se agregan los nodos adyacentes al
+ * vértice actual a la cola de nodos incompatibles. Después de procesar todos los vértices restantes, se guarda el
+ * grupo actual en la lista de grupos.
+ *
+ * Si se recibe un avance, se publica en él el número de vértices asignados y de fases creadas, y se revisa
+ * antes de cada vértice si la planificación fue cancelada.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo en el que se crearán los grupos.
+ * - groupList: Lista de grupos (vacía) en la que se guardarán los grupos creados.
+ * - progress: Avance compartido con otro hilo, o NULL.
+ *
+ * Retorno:
+ * - true si se asignaron todos los vértices.
+ * - false si la planificación fue cancelada; la lista queda con los grupos creados hasta ese momento.
+ */
+bool buildGroupList(Graph *graph, GroupList *groupList,
+                    PlanningProgress *progress) {
+  groupList->head = NULL;
+  groupList->tail = NULL;
 
   bool allVerticesAdded = false;
 
@@ -307,14 +362,26 @@ void createGroups(Graph *graph) {
     int groupNodesCount = 0;
     Queue *incompatibleNodes = createQueue();
     for (int i = searchedNodes; i < graph->numVertices; i++) {
+      if (planningCancelled(progress)) {
+        for (int k = 0; k < groupNodesCount; k++) {
+          free(groupNodes[k]);
+        }
+        free(groupNodes);
+        freeQueue(incompatibleNodes);
+        return false;
+      }
+
       // Si graph->adjacencyList[i]->name existe en un grupo, continuar
       // con la siguiente iteracion
-      if (isStringInGroups(&groupList, graph->adjacencyList[i]->name)) {
+      if (isStringInGroups(groupList, graph->adjacencyList[i]->name)) {
         continue;
       }
 
-      // Añadir vertice al grupo
-      if (!isPartOfQueue(incompatibleNodes, graph->adjacencyList[i])) {
+      // Añadir vertice al grupo si no es incompatible, en ningún sentido, con
+      // los que ya están en él
+      if (!isPartOfQueue(incompatibleNodes, graph->adjacencyList[i]) &&
+          !conflictsWithGroup(graph, groupNodes, groupNodesCount,
+                              graph->adjacencyList[i]->name)) {
         groupNodes[groupNodesCount] = strdup(graph->adjacencyList[i]->name);
         groupNodesCount++;
         vertexAdded++;
@@ -328,15 +395,30 @@ void createGroups(Graph *graph) {
       }
     }
     // guardar Grupo
-    addGroup(&groupList, groupNodes, groupNodesCount);
+    addGroup(groupList, groupNodes, groupNodesCount);
     allVerticesAdded = (vertexAdded == graph->numVertices);
+    if (progress != NULL) {
+      atomic_store(&progress->verticesAssigned, vertexAdded);
+      atomic_fetch_add(&progress->phases, 1);
+    }
 
     searchedNodes++;
-    free(incompatibleNodes);
+    freeQueue(incompatibleNodes);
   }
-  printGroupList(&groupList);
+  return true;
+}
 
-  Group *currentGroup = groupList.head;
+/*
+ * Función: freeGroupList
+ * Libera la memoria de todos los grupos de la lista.
+ *
+ * Parámetros:
+ * - groupList: Puntero a la lista de grupos que se liberará. Queda vacía.
+ *
+ * Retorno: Ninguno.
+ */
+void freeGroupList(GroupList *groupList) {
+  Group *currentGroup = groupList->head;
   while (currentGroup != NULL) {
     for (int i = 0; i < currentGroup->numTurns; i++) {
       free(currentGroup->turns[i]);
@@ -347,4 +429,117 @@ void createGroups(Graph *graph) {
     free(currentGroup);
     currentGroup = nextGroup;
   }
+  groupList->head = NULL;
+  groupList->tail = NULL;
+}
+
+/*
+ * Función: planGroups
+ * Ejecuta todas las etapas de la planificación de fases sobre el grafo.
+ *
+ * Descripción:
+ * Construye la lista de grupos con buildGroupList(), o con buildWeightedGroupList() si se recibe la demanda de
+ * cada cruce (sección [flujos] del grafo o un perfil), extiende cada fase con los cruces compatibles que puedan
+ * traslaparse (extendGroupsToMaximal()) y ordena las fases para minimizar el tiempo perdido por despeje entre fases
+ * (sequenceGroupList()). Entre etapas se publica la etapa en curso en el avance y se revisa si fue cancelada.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - flows: Demanda de cada cruce en veh/h para la agrupación ponderada, o NULL.
+ * - groupList: Lista (vacía) donde se guardan las fases.
+ * - lostTime: Donde se escribe el tiempo perdido por ciclo en segundos, o NULL.
+ * - progress: Avance compartido con otro hilo, o NULL.
+ *
+ * Retorno:
+ * - true si la planificación terminó.
+ * - false si fue cancelada o no hubo memoria; la lista queda vacía.
+ */
+bool planGroups(Graph *graph, const double *flows, GroupList *groupList,
+                double *lostTime, PlanningProgress *progress) {
+  if (progress != NULL) {
+    atomic_store(&progress->stage, STAGE_GROUPING);
+  }
+  traceEvent(TRACE_STAGE_BEGIN, STAGE_GROUPING, 0);
+  bool completed =
+      flows != NULL
+          ? buildWeightedGroupList(graph, flows, groupList, progress)
+          : buildGroupList(graph, groupList, progress);
+  traceEvent(TRACE_STAGE_END, STAGE_GROUPING, 0);
+  if (!completed) {
+    freeGroupList(groupList);
+    return false;
+  }
+
+  if (progress != NULL) {
+    atomic_store(&progress->stage, STAGE_OVERLAP);
+  }
+  traceEvent(TRACE_STAGE_BEGIN, STAGE_OVERLAP, 0);
+  int extended = extendGroupsToMaximal(graph, groupList, progress);
+  traceEvent(TRACE_STAGE_END, STAGE_OVERLAP, 0);
+  if (extended < 0 || planningCancelled(progress)) {
+    freeGroupList(groupList);
+    return false;
+  }
+
+  if (progress != NULL) {
+    atomic_store(&progress->stage, STAGE_SEQUENCING);
+  }
+  traceEvent(TRACE_STAGE_BEGIN, STAGE_SEQUENCING, 0);
+  double time = sequenceGroupList(graph, groupList, progress);
+  traceEvent(TRACE_STAGE_END, STAGE_SEQUENCING, 0);
+  if (time < 0 || planningCancelled(progress)) {
+    freeGroupList(groupList);
+    return false;
+  }
+  if (lostTime != NULL) {
+    *lostTime = time;
+  }
+  return true;
+}
+
+/*
+ * Función: printPlanningResult
+ * Imprime las fases, la fracción del ciclo con verde de cada cruce según los tiempos de Webster y el tiempo
+ * perdido por ciclo.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - groupList: Lista de grupos planificada.
+ * - lostTime: Tiempo perdido por ciclo en segundos.
+ *
+ * Retorno: Ninguno.
+ */
+void printPlanningResult(Graph *graph, GroupList *groupList, double lostTime) {
+  printGroupList(groupList);
+  PhasePlan plan;
+  if (planFromGroupList(graph, groupList, graph->flow, &plan) == 0) {
+    printGreenRatios(graph, &plan);
+  }
+  printf("Tiempo perdido por ciclo (despeje): %.1f s\r\n", lostTime);
+  double ratio =
+      graph->flow != NULL ? criticalFlowRatio(graph, graph->flow, groupList)
+                          : -1;
+  if (ratio >= 0) {
+    printf("Suma de razones criticas (Y): %.3f\r\n", ratio);
+  }
+}
+
+/*
+    Función: createGroups
+    Crea grupos de vértices en el grafo y los muestra.
+    Descripción:
+    Esta función planifica las fases con planGroups() en el hilo actual,
+   imprime el resultado con printPlanningResult() y finalmente libera los
+   recursos utilizados por los grupos. Si el archivo de entrada tiene la
+   sección [flujos], las fases se agrupan ponderando la demanda.
+    Parámetros:
+        graph: Puntero al grafo en el que se crearán los grupos.
+    Retorno: Ninguno.
+    */
+void createGroups(Graph *graph) {
+  GroupList groupList;
+  double lostTime = 0;
+  planGroups(graph, graph->flow, &groupList, &lostTime, NULL);
+  printPlanningResult(graph, &groupList, lostTime);
+  freeGroupList(&groupList);
 }
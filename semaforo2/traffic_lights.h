@@ -2,7 +2,9 @@
 #define TRAFFIC_LIGHTS_H
 
 #include "graph.h"
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 // Estructuras
 typedef struct Group {
@@ -16,6 +18,20 @@ typedef struct GroupList {
   Group *tail;
 } GroupList;
 
+// Avance de la planificación, compartido con el hilo de la interfaz.
+// Si `cancelled` se activa, la planificación se detiene en el siguiente vértice
+// (agrupación), grupo (traslape) o pasada de mejora (secuencia).
+typedef struct PlanningProgress {
+  atomic_int stage; // TraceStage en curso
+  atomic_int verticesAssigned;
+  atomic_int phases;
+  atomic_bool cancelled;
+} PlanningProgress;
+
+static inline bool planningCancelled(PlanningProgress *progress) {
+  return progress != NULL && atomic_load(&progress->cancelled);
+}
+
 typedef struct QueueNode {
   Node *data;
   struct QueueNode *next;
@@ -28,6 +44,12 @@ typedef struct Queue {
 
 // Funciones a implementar en traffic_lights.c
 void createGroups(Graph *graph);
+bool buildGroupList(Graph *graph, GroupList *groupList,
+                    PlanningProgress *progress);
+bool planGroups(Graph *graph, const double *flows, GroupList *groupList,
+                double *lostTime, PlanningProgress *progress);
+void printPlanningResult(Graph *graph, GroupList *groupList, double lostTime);
+void freeGroupList(GroupList *groupList);
 void addGroup(GroupList *groupList, char **groupNodes, int groupCount);
 bool isStringInGroups(GroupList *groupList, const char *searchString);
 void printGroupList(GroupList *groupList);
@@ -39,5 +61,6 @@ void enqueue(Queue *queue, Node *data);
 Node *dequeue(Queue *queue);
 bool isQueueEmpty(Queue *queue);
 bool isPartOfQueue(Queue *queue, Node *node);
+void freeQueue(Queue *queue);
 
 #endif
@@ -1,11 +1,19 @@
 #include "user_interface.h"
 #include "graph.h"
+#include "phase_plan.h"
+#include "planner_worker.h"
+#include "runtime.h"
+#include "trace.h"
 #include "traffic_lights.h"
 
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <ctype.h>
@@ -18,15 +26,42 @@
 #define RESALTAR "\x1b[30m\x1b[47m"
 #define RESET_COLOR "\x1b[0m"
 
+#define VERDE "\x1b[32m"
+#define ROJO "\x1b[31m"
+#define BORRAR_LINEA "\x1b[K"
+
+// Intervalo de refresco del avance mientras se planifica en segundo plano
+#define PROGRESS_REFRESH_MS 100
+// Espera máxima entre los bytes de una secuencia de escape, como las flechas
+#define ESCAPE_SEQUENCE_MS 10
+
+// Panel en vivo
+#define DASHBOARD_FPS 30
+#define DASHBOARD_INTERSECTIONS 2
+#define DASHBOARD_FLOW 300.0 // veh/h por cruce si el grafo no tiene [flujos]
+#define DASHBOARD_LEVELS 5 // Niveles de variación de la demanda entre intersecciones
+#define DASHBOARD_BAR_WIDTH 40 // Un bloque por vehículo en espera
+#define FRAME_BUFFER_SIZE 65536
+#define FRAME_NS (1000000000ull / DASHBOARD_FPS)
+
 struct termios orig_terminal;
 
 
 // Variables globales para el menu
 Graph *graph;
-char *option[] = {"Imprimir grafo", "Mostrar Cruces"};
-int numOptions = 2;
+char *option[] = {"Imprimir grafo", "Mostrar Cruces", "Panel en vivo"};
+int numOptions = 3;
 int selectedOption = 0;
 bool inMenu = true;
+PlanningJob planningJob;
+
+// Variables globales para el panel en vivo
+Runtime *dashboard = NULL;
+PhasePlan dashboardPlans[DASHBOARD_INTERSECTIONS];
+double *dashboardFlows = NULL; // numVertices valores por intersección
+uint64_t nextFrame; // ns de CLOCK_MONOTONIC del siguiente cuadro
+char frame[FRAME_BUFFER_SIZE];
+int frameLength;
 
 void disableRawMode() {
   SEQUENCE("\x1b[?25h", 6); // Muestra el cursor en la terminal
@@ -52,6 +87,37 @@ void clearScreen() {
   SEQUENCE("\x1b[H", 3);
 }
 
+/*
+ * Función: isLoneEscape
+ * Indica si el Esc recién leído es la tecla Esc sola y no el inicio de una secuencia de escape.
+ *
+ * Descripción:
+ * Las flechas y otras teclas especiales llegan como varios bytes seguidos (por ejemplo ESC [ A). Si tras el Esc
+ * llega otro byte antes de ESCAPE_SEQUENCE_MS, se lee la secuencia completa hasta su byte final y se descarta,
+ * para que no se interprete como Esc ni deje caracteres sueltos para el menu.
+ *
+ * Retorno:
+ * - true si se presionó solo Esc.
+ * - false si era una secuencia, que ya quedó consumida.
+ */
+static bool isLoneEscape() {
+  struct pollfd fd = {STDIN_FILENO, POLLIN, 0};
+  char c;
+  if (poll(&fd, 1, ESCAPE_SEQUENCE_MS) <= 0 || read(STDIN_FILENO, &c, 1) != 1) {
+    return true;
+  }
+  if (c != '[' && c != 'O') {
+    return false; // Alt + tecla
+  }
+  // Parámetros e intermedios hasta el byte final, entre '@' y '~'
+  do {
+    if (poll(&fd, 1, ESCAPE_SEQUENCE_MS) <= 0 ||
+        read(STDIN_FILENO, &c, 1) != 1) {
+      break;
+    }
+  } while (c < '@' || c > '~');
+  return false;
+}
 
 void processKeypress(char c) {
   if (c == '\x1b') { // Revisa si la tecla presionada es una `Escape sequence`
@@ -71,7 +137,7 @@ void processKeypress(char c) {
         break;
       // Flecha hacia abajo
       case 'B':
-        if (selectedOption < 2 - 1) {
+        if (selectedOption < numOptions - 1) {
           selectedOption++;
         }
         break;
@@ -89,7 +155,21 @@ void processKeypress(char c) {
         inMenu = false;
       }
       if (selectedOption == 1) {
-        createGroups(graph);
+        if (startPlanning(&planningJob, graph) == 0) {
+          drawPlanningProgress();
+        } else {
+          createGroups(graph); // Sin hilo disponible se planifica aquí mismo
+        }
+        inMenu = false;
+      }
+      if (selectedOption == 2) {
+        clearScreen();
+        if (startDashboard() == 0) {
+          drawDashboard();
+        } else {
+          printf("\nPresione " RESALTAR "Esc" RESET_COLOR
+                 " para regresar al menu.\r\n");
+        }
         inMenu = false;
       }
       break;
@@ -100,14 +180,14 @@ void processKeypress(char c) {
 void drawMenu() {
   // Opciones
   printf("╔═══════════════════╗\r\n");
-  for (int i = 0; i < 2; i++) {
+  for (int i = 0; i < numOptions; i++) {
     printf("║");
     if (i == selectedOption) {
       printf(">> ");
     } else {
       printf("   ");
     }
-    printf("%s  ║\r\n", option[i]);
+    printf("%-14s  ║\r\n", option[i]);
   }
   printf("╚═══════════════════╝\r\n");
 }
@@ -137,6 +217,212 @@ void drawGraph(Graph *graph) {
 }
 
 
+void drawPlanningProgress() {
+  static const char *stageNames[] = {"agrupacion", "traslape", "secuencia"};
+  int stage = atomic_load(&planningJob.progress.stage);
+  printf("Planificando fases (%s): %d/%d vertices asignados, %d fases\r\n",
+         stage >= 0 && stage <= STAGE_SEQUENCING ? stageNames[stage] : "?",
+         atomic_load(&planningJob.progress.verticesAssigned),
+         graph->numVertices, atomic_load(&planningJob.progress.phases));
+  printf("\nPresione " RESALTAR "Esc" RESET_COLOR " para cancelar.\r\n");
+}
+
+void drawPlanningResult() {
+  if (finishPlanning(&planningJob)) {
+    printPlanningResult(graph, &planningJob.groupList, planningJob.lostTime);
+    freeGroupList(&planningJob.groupList);
+  }
+  printf("\nPresione " RESALTAR "Esc" RESET_COLOR
+         " para regresar al menu.\r\n");
+}
+
+static uint64_t monotonicNs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/*
+ * Función: startDashboard
+ * Pone a correr en tiempo real DASHBOARD_INTERSECTIONS controladores del grafo para el panel en vivo.
+ *
+ * Descripción:
+ * La demanda base es la de la sección [flujos] del grafo o, si no la tiene, DASHBOARD_FLOW en cada cruce. La
+ * intersección 0 usa la demanda base y las demás la misma escalada por cruce entre 0.5 y 1.5 veces, como cruces
+ * vecinos de un corredor con distinta carga; cada una tiene así su propio plan, con sus fases y su ciclo. Los
+ * controladores corren en su propio hilo y publican su estado en cada tick; el panel solo lee esas publicaciones.
+ *
+ * Retorno:
+ * - 0 si el entorno quedó corriendo.
+ * - -1 si no se pudo construir el plan o crear el entorno.
+ */
+int startDashboard() {
+  int n = graph->numVertices;
+  dashboardFlows =
+      (double *)malloc((size_t)n * DASHBOARD_INTERSECTIONS * sizeof(double));
+  if (dashboardFlows == NULL) {
+    printf("Error: No se pudo asignar la demanda del panel en memoria.\r\n");
+    return -1;
+  }
+
+  const PhasePlan *plans[DASHBOARD_INTERSECTIONS];
+  const double *flows[DASHBOARD_INTERSECTIONS];
+  for (int k = 0; k < DASHBOARD_INTERSECTIONS; k++) {
+    double *demand = dashboardFlows + (size_t)k * n;
+    for (int i = 0; i < n; i++) {
+      double base = graph->flow != NULL ? graph->flow[i] : DASHBOARD_FLOW;
+      int level = k == 0 ? DASHBOARD_LEVELS / 2
+                         : (k * 7 + i * 3) % DASHBOARD_LEVELS;
+      demand[i] = base * (0.5 + (double)level / (DASHBOARD_LEVELS - 1));
+    }
+    if (buildPhasePlan(graph, demand, &dashboardPlans[k]) != 0) {
+      printf("Error: El plan excede %d cruces o %d fases, o junta cruces "
+             "incompatibles.\r\n",
+             PLAN_MAX_MOVEMENTS, PLAN_MAX_PHASES);
+      stopDashboard();
+      return -1;
+    }
+    plans[k] = &dashboardPlans[k];
+    flows[k] = demand;
+  }
+  RuntimeConfig config;
+  config.numShards = 1;
+  config.duration = 0;
+  config.realTime = true;
+  config.pinThreads = false;
+  config.numSnapshots = DASHBOARD_INTERSECTIONS;
+  dashboard = createRuntime(&config, plans, flows, DASHBOARD_INTERSECTIONS);
+  if (dashboard == NULL || startRuntime(dashboard) != 0) {
+    stopDashboard();
+    return -1;
+  }
+  nextFrame = monotonicNs();
+  return 0;
+}
+
+/*
+ * Función: stopDashboard
+ * Detiene los controladores del panel en vivo y libera su memoria.
+ */
+void stopDashboard() {
+  freeRuntime(dashboard);
+  dashboard = NULL;
+  free(dashboardFlows);
+  dashboardFlows = NULL;
+}
+
+/*
+ * Función: appendFrame
+ * Agrega texto con formato al cuadro en construcción; lo que no cabe se descarta.
+ */
+static void appendFrame(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(frame + frameLength, FRAME_BUFFER_SIZE - frameLength,
+                         format, args);
+  va_end(args);
+  if (length > 0) {
+    frameLength += length;
+  }
+  if (frameLength > FRAME_BUFFER_SIZE - 1) {
+    frameLength = FRAME_BUFFER_SIZE - 1;
+  }
+}
+
+/*
+ * Función: writeFrame
+ * Escribe el cuadro completo en la terminal, repitiendo write() si escribe solo una parte o lo interrumpe una señal.
+ */
+static void writeFrame(const char *buffer, int length) {
+  while (length > 0) {
+    ssize_t written = SEQUENCE(buffer, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    buffer += written;
+    length -= (int)written;
+  }
+}
+
+/*
+ * Función: dashboardTimeout
+ * Devuelve los ms que faltan para el siguiente cuadro del panel, para esperar las teclas con poll().
+ */
+int dashboardTimeout() {
+  uint64_t now = monotonicNs();
+  return nextFrame > now ? (int)((nextFrame - now + 999999) / 1000000) : 0;
+}
+
+/*
+ * Función: drawDashboard
+ * Dibuja un cuadro del panel en vivo con la fase activa, el tiempo restante y la cola de cada cruce.
+ *
+ * Descripción:
+ * El cuadro se arma completo en memoria y se escribe de una vez con writeFrame(), sobre la pantalla anterior y
+ * borrando el resto de cada línea, de modo que no parpadea. El estado se toma de las publicaciones de los
+ * controladores, así que dibujar nunca detiene su hilo. Programa el siguiente cuadro a intervalos fijos de
+ * 1/DASHBOARD_FPS s; si el anterior se atrasó, se descartan los cuadros perdidos en lugar de acumularlos.
+ */
+void drawDashboard() {
+  frameLength = 0;
+  appendFrame("\x1b[H" "Panel en vivo: %d intersecciones, %d cuadros/s"
+              BORRAR_LINEA "\r\n" BORRAR_LINEA "\r\n",
+              DASHBOARD_INTERSECTIONS, DASHBOARD_FPS);
+
+  for (int k = 0; k < DASHBOARD_INTERSECTIONS; k++) {
+    ControllerSnapshot snapshot;
+    if (readControllerSnapshot(dashboard, k, &snapshot) != 0) {
+      appendFrame("Interseccion %d: esperando el primer tick" BORRAR_LINEA
+                  "\r\n",
+                  k);
+      continue;
+    }
+    appendFrame("Interseccion %d  ciclo %.1f s  t = %.1f s  ", k,
+                dashboardPlans[k].cycle / 10.0, snapshot.tick / 10.0);
+    if (snapshot.clearing) {
+      appendFrame("despeje de fase %d a fase %d", snapshot.phase + 1,
+                  snapshot.next + 1);
+    } else {
+      appendFrame(RESALTAR "fase %d de %d" RESET_COLOR, snapshot.phase + 1,
+                  snapshot.numPhases);
+    }
+    appendFrame(", cambia en %.1f s" BORRAR_LINEA "\r\n",
+                snapshot.remaining / 10.0);
+
+    for (int i = 0; i < snapshot.numMovements; i++) {
+      bool green = (snapshot.greenMask >> i) & 1;
+      int blocks = (int)(snapshot.queue[i] + 0.5f);
+      appendFrame("  %-6s %s", graph->adjacencyList[i]->name,
+                  green ? VERDE : ROJO);
+      for (int b = 0; b < DASHBOARD_BAR_WIDTH; b++) {
+        appendFrame("%s", b < blocks ? "█" : " ");
+      }
+      appendFrame(RESET_COLOR "%c%5.1f veh" BORRAR_LINEA "\r\n",
+                  blocks > DASHBOARD_BAR_WIDTH ? '+' : ' ', snapshot.queue[i]);
+    }
+    appendFrame(BORRAR_LINEA "\r\n");
+  }
+  appendFrame("Presione " RESALTAR "Esc" RESET_COLOR
+              " para regresar al menu." BORRAR_LINEA "\r\n\x1b[J");
+  writeFrame(frame, frameLength);
+
+  uint64_t now = monotonicNs();
+  nextFrame += FRAME_NS;
+  if (nextFrame <= now) {
+    nextFrame = now + FRAME_NS;
+  }
+}
+
+void redrawScreen() {
+  clearScreen();
+  printf("Guia: Use las flechas para moverse por el menu | Presione Enter "
+         "para seleccionar\r\n\n");
+  drawMenu();
+}
+
 int iniciarMenu() {
   char filename[15];
   clearScreen();
@@ -144,34 +430,96 @@ int iniciarMenu() {
   scanf("%s", filename);
   graph = readGraphFromFile(filename);
   enableRawMode();
-  printf("Guia: Use las flechas para moverse por el menu | Presione Enter para "
-         "seleccionar\r\n\n");
-  drawMenu();
+  redrawScreen();
+  // Se esperan a la vez las teclas y el aviso de fin de la planificación en
+  // segundo plano, para que Esc pueda cancelarla mientras se ejecuta
+  struct pollfd fds[2];
   char c;
-  while (read(STDIN_FILENO, &c, 1) == 1) {
-    clearScreen();
-    printf("Guia: Use las flechas para moverse por el menu | Presione Enter "
-           "para seleccionar\r\n\n");
-    drawMenu();
-    if (inMenu) {
+  while (true) {
+    fds[0].fd = STDIN_FILENO;
+    fds[0].events = POLLIN;
+    fds[1].fd = planningJob.running ? planningJob.eventFd : -1;
+    fds[1].events = POLLIN;
+    int timeout = -1;
+    if (dashboard != NULL) {
+      timeout = dashboardTimeout();
+    } else if (planningJob.running) {
+      timeout = PROGRESS_REFRESH_MS;
+    }
+    int ready = poll(fds, 2, timeout);
+    if (ready == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    // El panel se redibuja a su ritmo y solo atiende Esc
+    if (dashboard != NULL) {
+      if (dashboardTimeout() == 0) {
+        drawDashboard();
+      }
+      if (!(fds[0].revents & POLLIN)) {
+        continue;
+      }
+      if (read(STDIN_FILENO, &c, 1) != 1) {
+        break;
+      }
+      if (c == 27 && isLoneEscape()) {
+        stopDashboard();
+        inMenu = true;
+        redrawScreen();
+      }
+      continue;
+    }
+
+    if (planningJob.running && (fds[1].revents & POLLIN)) {
+      redrawScreen();
+      drawPlanningResult();
+    } else if (planningJob.running && !(fds[0].revents & POLLIN)) {
+      redrawScreen();
+      drawPlanningProgress();
+    }
+    if (!(fds[0].revents & POLLIN)) {
+      continue;
+    }
+    if (read(STDIN_FILENO, &c, 1) != 1) {
+      break;
+    }
+
+    redrawScreen();
+    if (planningJob.running) {
+      if (c == 27 && isLoneEscape()) {
+        cancelPlanning(&planningJob);
+        if (finishPlanning(&planningJob)) {
+          // Terminó antes de ver la cancelación: su resultado se descarta
+          freeGroupList(&planningJob.groupList);
+        }
+        clearScreen();
+        inMenu = true;
+      } else {
+        drawPlanningProgress();
+      }
+    } else if (inMenu) {
       processKeypress(c);
     } else {
-      if (c == 27) {
+      if (c == 27 && isLoneEscape()) {
         clearScreen();
         inMenu = true;
       }
     }
   }
-  for (int i = 0; i < graph->numVertices; i++) {
-    Node *currentNode = graph->adjacencyList[i];
-    Node *nextNode;
-    while (currentNode != NULL) {
-      nextNode = currentNode->next;
-      free(currentNode);
-      currentNode = nextNode;
+  if (planningJob.running) {
+    cancelPlanning(&planningJob);
+    if (finishPlanning(&planningJob)) {
+      freeGroupList(&planningJob.groupList);
     }
   }
-  free(graph->adjacencyList);
+  if (dashboard != NULL) {
+    stopDashboard();
+  }
+  freeGraph(graph);
+  graph = NULL;
 
   return 0;
 }
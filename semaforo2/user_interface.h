@@ -8,6 +8,13 @@ void enableRawMode();
 void drawGraph(Graph *graph);
 void drawMenu();
 void processKeypress(char c);
+void drawPlanningProgress();
+void drawPlanningResult();
+int startDashboard();
+void stopDashboard();
+int dashboardTimeout();
+void drawDashboard();
+void redrawScreen();
 
 void clearScreen();
 
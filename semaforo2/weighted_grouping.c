@@ -0,0 +1,477 @@
+#include "weighted_grouping.h"
+#include "bitset.h"
+#include "conflicts.h"
+#include "graph.h"
+#include "phase_plan.h"
+#include "traffic_lights.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RATIO_EPSILON 1e-9
+
+// Fases en construcción: conjunto de cruces de cada fase y sus dos mayores
+// razones de flujo, para evaluar en O(1) cuánto cambia la razón crítica de una
+// fase al quitarle su cruce más cargado
+typedef struct WeightedPhases {
+  int words;
+  int numPhases;
+  uint64_t *members; // numVertices fases de `words` palabras
+  double *top;       // Razón crítica de cada fase
+  double *second;    // Mayor razón sin contar al cruce `topIndex`
+  int *topIndex;     // Cruce con la razón crítica, o -1 si la fase está vacía
+  int *moved;        // Cruces reubicados al intentar disolver una fase
+  int *movedTo;      // Fase de destino de cada cruce reubicado
+} WeightedPhases;
+
+typedef struct RatioEntry {
+  double ratio;
+  int index;
+} RatioEntry;
+
+static int compareRatioDescending(const void *a, const void *b) {
+  const RatioEntry *x = (const RatioEntry *)a;
+  const RatioEntry *y = (const RatioEntry *)b;
+  if (x->ratio != y->ratio) {
+    return x->ratio < y->ratio ? 1 : -1;
+  }
+  return x->index - y->index;
+}
+
+static inline uint64_t *phaseMembers(WeightedPhases *phases, int p) {
+  return phases->members + (size_t)p * phases->words;
+}
+
+/*
+ * Función: updatePhaseTop
+ * Recalcula la mayor y la segunda mayor razón de flujo de una fase.
+ */
+static void updatePhaseTop(WeightedPhases *phases, const double *ratio,
+                           int p) {
+  uint64_t *set = phaseMembers(phases, p);
+  phases->top[p] = 0;
+  phases->second[p] = 0;
+  phases->topIndex[p] = -1;
+  for (int i = bitsetNext(set, phases->words, 0); i != -1;
+       i = bitsetNext(set, phases->words, i + 1)) {
+    if (phases->topIndex[p] == -1 || ratio[i] > phases->top[p]) {
+      phases->second[p] = phases->top[p];
+      phases->top[p] = ratio[i];
+      phases->topIndex[p] = i;
+    } else if (ratio[i] > phases->second[p]) {
+      phases->second[p] = ratio[i];
+    }
+  }
+}
+
+/*
+ * Función: conflictsExcept
+ * Indica si el cruce de la fila de conflictos `row` choca con algún cruce de `set` distinto de `except`.
+ */
+static bool conflictsExcept(const uint64_t *row, const uint64_t *set,
+                            int words, int except) {
+  for (int w = 0; w < words; w++) {
+    uint64_t word = row[w] & set[w];
+    if (w == except >> 6) {
+      word &= ~((uint64_t)1 << (except & 63));
+    }
+    if (word) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Función: removeEmptyPhase
+ * Quita una fase vacía moviendo la última fase a su lugar.
+ */
+static void removeEmptyPhase(WeightedPhases *phases, int p) {
+  int last = --phases->numPhases;
+  if (p != last) {
+    memcpy(phaseMembers(phases, p), phaseMembers(phases, last),
+           phases->words * sizeof(uint64_t));
+    phases->top[p] = phases->top[last];
+    phases->second[p] = phases->second[last];
+    phases->topIndex[p] = phases->topIndex[last];
+  }
+}
+
+/*
+ * Función: improvePhase
+ * Intenta reducir la razón crítica de la fase `a` sacando su cruce más cargado.
+ *
+ * Descripción:
+ * Solo sacar al cruce que define la razón crítica puede reducirla, así que se prueba moverlo a otra fase con la
+ * que sea compatible o, si en otra fase choca con un solo cruce j, moverlo ahí y mover j a una tercera fase (o a la
+ * fase de origen, lo que equivale a intercambiarlos). Se aplica el primer cambio que reduce la suma de razones
+ * críticas de las fases involucradas.
+ *
+ * Retorno:
+ * - true si se aplicó un cambio.
+ */
+static bool improvePhase(WeightedPhases *phases, ConflictMatrix *conflicts,
+                         const double *ratio, int a) {
+  int i = phases->topIndex[a];
+  if (i == -1 || phases->top[a] - phases->second[a] <= RATIO_EPSILON) {
+    return false;
+  }
+  uint64_t *row = conflictRow(conflicts, i);
+  uint64_t *setA = phaseMembers(phases, a);
+  int words = phases->words;
+
+  // Mover el cruce a otra fase
+  for (int b = 0; b < phases->numPhases; b++) {
+    if (b == a) {
+      continue;
+    }
+    double newB = ratio[i] > phases->top[b] ? ratio[i] : phases->top[b];
+    double delta =
+        newB - phases->top[b] + phases->second[a] - phases->top[a];
+    uint64_t *setB = phaseMembers(phases, b);
+    if (delta < -RATIO_EPSILON && !bitsetIntersects(row, setB, words)) {
+      bitsetReset(setA, i);
+      bitsetSet(setB, i);
+      updatePhaseTop(phases, ratio, a);
+      updatePhaseTop(phases, ratio, b);
+      if (phases->topIndex[a] == -1) {
+        removeEmptyPhase(phases, a);
+      }
+      return true;
+    }
+  }
+
+  // Moverlo a una fase b donde choca solo con j, y mover j a otra fase c
+  for (int b = 0; b < phases->numPhases; b++) {
+    if (b == a) {
+      continue;
+    }
+    uint64_t *setB = phaseMembers(phases, b);
+    int j = -1;
+    int shared = 0;
+    for (int w = 0; w < words && shared < 2; w++) {
+      uint64_t word = row[w] & setB[w];
+      if (word) {
+        shared += __builtin_popcountll(word);
+        j = (w << 6) + __builtin_ctzll(word);
+      }
+    }
+    if (shared != 1) {
+      continue;
+    }
+
+    double restB =
+        j == phases->topIndex[b] ? phases->second[b] : phases->top[b];
+    double newB = ratio[i] > restB ? ratio[i] : restB;
+    for (int c = 0; c < phases->numPhases; c++) {
+      if (c == b) {
+        continue;
+      }
+      // Si c es la fase de origen, j reemplaza a i
+      double baseC = c == a ? phases->second[a] : phases->top[c];
+      double newC = ratio[j] > baseC ? ratio[j] : baseC;
+      double delta = newB - phases->top[b] + newC - phases->top[c];
+      if (c != a) {
+        delta += phases->second[a] - phases->top[a];
+      }
+      uint64_t *setC = phaseMembers(phases, c);
+      if (delta < -RATIO_EPSILON &&
+          !conflictsExcept(conflictRow(conflicts, j), setC, words,
+                           c == a ? i : j)) {
+        bitsetReset(setA, i);
+        bitsetReset(setB, j);
+        bitsetSet(setB, i);
+        bitsetSet(setC, j);
+        updatePhaseTop(phases, ratio, a);
+        updatePhaseTop(phases, ratio, b);
+        updatePhaseTop(phases, ratio, c);
+        if (phases->topIndex[a] == -1) {
+          removeEmptyPhase(phases, a);
+        }
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/*
+ * Función: dissolvePhase
+ * Intenta eliminar la fase `a` repartiendo todos sus cruces entre las demás fases.
+ *
+ * Descripción:
+ * Eliminar la fase ahorra su razón crítica; cada cruce se coloca en la fase compatible donde menos sube la razón
+ * crítica. Si algún cruce no cabe en ninguna fase, o el aumento total no es menor que el ahorro, se deshacen los
+ * movimientos.
+ *
+ * Retorno:
+ * - true si la fase se eliminó.
+ */
+static bool dissolvePhase(WeightedPhases *phases, ConflictMatrix *conflicts,
+                          const double *ratio, int a) {
+  uint64_t *setA = phaseMembers(phases, a);
+  int words = phases->words;
+  double increase = 0;
+  int numMoved = 0;
+  bool dissolved = true;
+  for (int j = bitsetNext(setA, words, 0); j != -1 && dissolved;
+       j = bitsetNext(setA, words, j + 1)) {
+    uint64_t *row = conflictRow(conflicts, j);
+    int best = -1;
+    double bestIncrease = 0;
+    for (int b = 0; b < phases->numPhases; b++) {
+      if (b == a || bitsetIntersects(row, phaseMembers(phases, b), words)) {
+        continue;
+      }
+      double rise = ratio[j] > phases->top[b] ? ratio[j] - phases->top[b] : 0;
+      if (best == -1 || rise < bestIncrease) {
+        best = b;
+        bestIncrease = rise;
+      }
+    }
+    if (best == -1 ||
+        increase + bestIncrease >= phases->top[a] - RATIO_EPSILON) {
+      dissolved = false;
+      break;
+    }
+    increase += bestIncrease;
+    bitsetSet(phaseMembers(phases, best), j);
+    if (ratio[j] > phases->top[best]) {
+      phases->top[best] = ratio[j]; // Provisional hasta updatePhaseTop()
+    }
+    phases->moved[numMoved] = j;
+    phases->movedTo[numMoved++] = best;
+  }
+
+  for (int k = 0; k < numMoved; k++) {
+    if (!dissolved) {
+      bitsetReset(phaseMembers(phases, phases->movedTo[k]), phases->moved[k]);
+    }
+    updatePhaseTop(phases, ratio, phases->movedTo[k]);
+  }
+  if (dissolved) {
+    bitsetClear(setA, words);
+    removeEmptyPhase(phases, a);
+  }
+  return dissolved;
+}
+
+/*
+ * Función: buildWeightedGroupList
+ * Construye la lista de grupos (fases) minimizando la suma de razones críticas de flujo.
+ *
+ * Descripción:
+ * La capacidad de la intersección depende de Y, la suma sobre las fases de la mayor razón demanda/saturación de
+ * sus cruces. Primero se asignan los cruces de mayor a menor razón a la primera fase compatible (first-fit
+ * decreciente), de modo que los cruces pesados abren fases y los siguientes cruces pesados compatibles se unen a
+ * ellas. Luego una búsqueda local mueve el cruce crítico de cada fase a otra fase (desplazando a lo sumo a un
+ * cruce) e intenta disolver fases repartiendo sus cruces entre las demás, mientras la suma baje,
+ * evaluando cada cambio en O(1) con las dos mayores razones de cada fase y verificando la compatibilidad con la
+ * matriz de conflictos de bits. A diferencia de buildGroupList(), los conflictos se toman en ambos sentidos.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - flows: Demanda de cada cruce en veh/h (numVertices valores).
+ * - groupList: Lista de grupos (vacía) en la que se guardarán los grupos creados.
+ * - progress: Avance compartido con otro hilo, o NULL.
+ *
+ * Retorno:
+ * - true si se asignaron todos los vértices.
+ * - false si la planificación fue cancelada o no hubo memoria; la lista queda vacía.
+ */
+bool buildWeightedGroupList(Graph *graph, const double *flows,
+                            GroupList *groupList, PlanningProgress *progress) {
+  groupList->head = NULL;
+  groupList->tail = NULL;
+  int n = graph->numVertices;
+  if (n == 0) {
+    return true;
+  }
+
+  ConflictMatrix *conflicts = buildConflictMatrix(graph);
+  if (conflicts == NULL) {
+    return false;
+  }
+  WeightedPhases phases;
+  phases.words = conflicts->words;
+  phases.numPhases = 0;
+  phases.members =
+      (uint64_t *)calloc((size_t)n * phases.words, sizeof(uint64_t));
+  phases.top = (double *)malloc(n * sizeof(double));
+  phases.second = (double *)malloc(n * sizeof(double));
+  phases.topIndex = (int *)malloc(n * sizeof(int));
+  phases.moved = (int *)malloc(n * sizeof(int));
+  phases.movedTo = (int *)malloc(n * sizeof(int));
+  double *ratio = (double *)malloc(n * sizeof(double));
+  RatioEntry *order = (RatioEntry *)malloc(n * sizeof(RatioEntry));
+  bool completed = phases.members != NULL && phases.top != NULL &&
+                   phases.second != NULL && phases.topIndex != NULL &&
+                   phases.moved != NULL && phases.movedTo != NULL &&
+                   ratio != NULL && order != NULL;
+  if (!completed) {
+    printf("Error: No se pudo asignar la agrupacion en memoria.\n");
+  }
+
+  for (int i = 0; i < n && completed; i++) {
+    ratio[i] = flows[i] > 0 ? flows[i] / SATURATION_FLOW : 0;
+    order[i].ratio = ratio[i];
+    order[i].index = i;
+  }
+  if (completed) {
+    qsort(order, n, sizeof(RatioEntry), compareRatioDescending);
+  }
+
+  for (int k = 0; k < n && completed; k++) {
+    int i = order[k].index;
+    uint64_t *row = conflictRow(conflicts, i);
+    int p = 0;
+    while (p < phases.numPhases &&
+           bitsetIntersects(row, phaseMembers(&phases, p), phases.words)) {
+      p++;
+    }
+    if (p == phases.numPhases) {
+      phases.numPhases++;
+      phases.topIndex[p] = -1;
+      if (progress != NULL) {
+        atomic_fetch_add(&progress->phases, 1);
+      }
+    }
+    bitsetSet(phaseMembers(&phases, p), i);
+    if (phases.topIndex[p] == -1) {
+      phases.top[p] = ratio[i];
+      phases.second[p] = 0;
+      phases.topIndex[p] = i;
+    } else if (ratio[i] > phases.second[p]) {
+      phases.second[p] = ratio[i]; // El orden es decreciente
+    }
+
+    if (progress != NULL) {
+      atomic_store(&progress->verticesAssigned, k + 1);
+      completed = !atomic_load(&progress->cancelled);
+    }
+  }
+
+  bool improved = completed;
+  for (int pass = 0; improved && pass < WEIGHTED_MAX_PASSES; pass++) {
+    improved = false;
+    for (int a = 0; a < phases.numPhases; a++) {
+      improved |= improvePhase(&phases, conflicts, ratio, a);
+    }
+    for (int a = phases.numPhases - 1; a >= 0; a--) {
+      improved |= dissolvePhase(&phases, conflicts, ratio, a);
+    }
+    if (progress != NULL) {
+      atomic_store(&progress->phases, phases.numPhases);
+      if (atomic_load(&progress->cancelled)) {
+        completed = false;
+      }
+    }
+    improved = improved && completed;
+  }
+
+  for (int p = 0; p < phases.numPhases && completed; p++) {
+    uint64_t *set = phaseMembers(&phases, p);
+    int count = bitsetCount(set, phases.words);
+    char **groupNodes = (char **)malloc((count + 1) * sizeof(char *));
+    int c = 0;
+    for (int i = bitsetNext(set, phases.words, 0);
+         i != -1 && groupNodes != NULL;
+         i = bitsetNext(set, phases.words, i + 1)) {
+      if ((groupNodes[c] = strdup(graph->adjacencyList[i]->name)) == NULL) {
+        break;
+      }
+      c++;
+    }
+    if (groupNodes == NULL || c < count) {
+      printf("Error: No se pudo asignar el grupo en memoria.\n");
+      for (int k = 0; groupNodes != NULL && k < c; k++) {
+        free(groupNodes[k]);
+      }
+      free(groupNodes);
+      freeGroupList(groupList);
+      completed = false;
+      break;
+    }
+    groupNodes[c] = NULL;
+    addGroup(groupList, groupNodes, count);
+  }
+
+  free(order);
+  free(ratio);
+  free(phases.movedTo);
+  free(phases.moved);
+  free(phases.topIndex);
+  free(phases.second);
+  free(phases.top);
+  free(phases.members);
+  freeConflictMatrix(conflicts);
+  return completed;
+}
+
+/*
+ * Función: criticalFlowRatio
+ * Calcula Y, la suma sobre las fases de la mayor razón demanda/saturación de sus cruces.
+ *
+ * Descripción:
+ * Igual que computeTiming(), un cruce con verde en varias fases reparte su demanda entre ellas. La capacidad de la
+ * intersección es inversamente proporcional a Y.
+ *
+ * Parámetros:
+ * - graph: Puntero al grafo.
+ * - flows: Demanda de cada cruce en veh/h.
+ * - groupList: Lista de grupos (fases).
+ *
+ * Retorno:
+ * - La suma de razones críticas.
+ * - -1 si no se puede asignar memoria.
+ */
+double criticalFlowRatio(Graph *graph, const double *flows,
+                         GroupList *groupList) {
+  int n = graph->numVertices;
+  int words = BITSET_WORDS(n);
+  int numGroups = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next) {
+    numGroups++;
+  }
+  if (numGroups == 0) {
+    return 0;
+  }
+
+  uint64_t *sets =
+      (uint64_t *)malloc((size_t)numGroups * words * sizeof(uint64_t));
+  int *served = (int *)calloc(n, sizeof(int));
+  if (sets == NULL || served == NULL) {
+    printf("Error: No se pudo asignar la razon de flujo en memoria.\n");
+    free(served);
+    free(sets);
+    return -1;
+  }
+  int k = 0;
+  for (Group *g = groupList->head; g != NULL; g = g->next, k++) {
+    uint64_t *set = sets + (size_t)k * words;
+    groupToBitset(graph, g, set, words);
+    for (int i = bitsetNext(set, words, 0); i != -1;
+         i = bitsetNext(set, words, i + 1)) {
+      served[i]++;
+    }
+  }
+
+  double total = 0;
+  for (k = 0; k < numGroups; k++) {
+    uint64_t *set = sets + (size_t)k * words;
+    double critical = 0;
+    for (int i = bitsetNext(set, words, 0); i != -1;
+         i = bitsetNext(set, words, i + 1)) {
+      double ratio = flows[i] / SATURATION_FLOW / served[i];
+      if (ratio > critical) {
+        critical = ratio;
+      }
+    }
+    total += critical;
+  }
+
+  free(served);
+  free(sets);
+  return total;
+}
@@ -0,0 +1,18 @@
+#ifndef WEIGHTED_GROUPING_H
+#define WEIGHTED_GROUPING_H
+
+#include "graph.h"
+#include "traffic_lights.h"
+#include <stdbool.h>
+
+// Límite de pasadas de la búsqueda local; cada pasada que mejora reduce la
+// suma de razones críticas, así que en la práctica termina mucho antes
+#define WEIGHTED_MAX_PASSES 200
+
+// Funciones a implementar en weighted_grouping.c
+bool buildWeightedGroupList(Graph *graph, const double *flows,
+                            GroupList *groupList, PlanningProgress *progress);
+double criticalFlowRatio(Graph *graph, const double *flows,
+                         GroupList *groupList);
+
+#endif
@@ -0,0 +1,149 @@
+#include "conflicts.h"
+#include "graph.h"
+#include "traffic_lights.h"
+#include "weighted_grouping.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Prueba de la agrupación ponderada: con demanda desigual entre los cruces debe
+// bajar la suma de razones críticas (Y) respecto de la agrupación original de
+// buildGroupList(), con las mismas etapas de traslape y secuencia y sin juntar
+// cruces incompatibles. Se usa con `make test`.
+#define TEST_INSTANCES 200
+#define TEST_MAX_VERTICES 14
+
+// Intersección de input.dat con la demanda del perfil AM de perfiles.dat
+static char *movements[] = {"AOAE", "AOCN", "AOCS", "AEAO", "AECN",
+                            "AECS", "CNAO", "CNCS", "CSAE", "CSCN"};
+static char *incompatible[][2] = {
+    {"AOAE", "CNCS"}, {"AOAE", "AECS"}, {"AOAE", "CSCN"}, {"AOAE", "CSAE"},
+    {"AOCN", "AECS"}, {"AOCN", "AECN"}, {"AEAO", "CSCN"}, {"AEAO", "AOCN"},
+    {"AEAO", "CNCS"}, {"AEAO", "CNAO"}, {"AECS", "AOCS"}, {"CNCS", "AOCN"},
+    {"CNCS", "AOCS"}, {"CNCS", "AECS"}, {"CSCN", "AECS"}, {"CSCN", "AECN"},
+    {"CSCN", "AOCN"}};
+static double morningFlows[] = {650, 180, 120, 600, 150,
+                                200, 90,  420, 110, 380};
+
+/*
+ * Función: nextRandom
+ * Siguiente valor de una secuencia xorshift64; la misma semilla da la misma secuencia.
+ */
+static uint64_t nextRandom(uint64_t *state) {
+  uint64_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return *state = x;
+}
+
+/*
+ * Función: createNamedGraph
+ * Crea un grafo sin incompatibilidades con los cruces nombrados V0, V1, ...
+ */
+static Graph *createNamedGraph(int numVertices) {
+  Graph *graph = createGraph(numVertices);
+  for (int i = 0; graph != NULL && i < numVertices; i++) {
+    Node *vertex = graph->adjacencyList[i];
+    snprintf(vertex->name, sizeof(vertex->name), "V%d", i);
+  }
+  return graph;
+}
+
+/*
+ * Función: compareGroupings
+ * Planifica el grafo con y sin demanda y devuelve el Y de cada agrupación.
+ *
+ * Retorno:
+ * - Número de errores encontrados: planificación fallida o cruces incompatibles en una misma fase.
+ */
+static int compareGroupings(Graph *graph, const double *flows,
+                            double *originalRatio, double *weightedRatio) {
+  GroupList original, weighted;
+  bool planned = planGroups(graph, NULL, &original, NULL, NULL);
+  planned = planGroups(graph, flows, &weighted, NULL, NULL) && planned;
+  int errors = 0;
+  if (!planned) {
+    printf("Error: No se pudieron planificar las fases.\n");
+    errors++;
+  } else if (countGroupConflicts(graph, &original) != 0 ||
+             countGroupConflicts(graph, &weighted) != 0) {
+    printf("Error: Una agrupacion junta cruces incompatibles.\n");
+    errors++;
+  }
+  *originalRatio = criticalFlowRatio(graph, flows, &original);
+  *weightedRatio = criticalFlowRatio(graph, flows, &weighted);
+  freeGroupList(&original);
+  freeGroupList(&weighted);
+  return errors;
+}
+
+int main(void) {
+  int errors = 0;
+  double originalRatio, weightedRatio;
+
+  // La intersección de ejemplo en la hora de máxima demanda
+  int n = sizeof(movements) / sizeof(movements[0]);
+  Graph *graph = createGraph(n);
+  if (graph == NULL) {
+    printf("Error: No se pudo crear el grafo de prueba.\n");
+    return 1;
+  }
+  for (int i = 0; i < n; i++) {
+    strcpy(graph->adjacencyList[i]->name, movements[i]);
+  }
+  for (size_t e = 0; e < sizeof(incompatible) / sizeof(incompatible[0]); e++) {
+    addEdge(graph, incompatible[e][0], incompatible[e][1]);
+  }
+  errors += compareGroupings(graph, morningFlows, &originalRatio,
+                             &weightedRatio);
+  if (!(weightedRatio < originalRatio)) {
+    printf("Error: Con el perfil AM la agrupacion ponderada dio Y = %.3f y la "
+           "original Y = %.3f.\n",
+           weightedRatio, originalRatio);
+    errors++;
+  }
+  printf("Perfil AM: Y original %.3f, ponderada %.3f\n", originalRatio,
+         weightedRatio);
+  freeGraph(graph);
+
+  // Grafos al azar donde unos pocos cruces concentran la demanda
+  uint64_t seed = 0x9e3779b97f4a7c15ull;
+  double flows[TEST_MAX_VERTICES];
+  double originalTotal = 0, weightedTotal = 0;
+  int lowered = 0, raised = 0;
+  for (int t = 0; t < TEST_INSTANCES; t++) {
+    n = 4 + (int)(nextRandom(&seed) % (TEST_MAX_VERTICES - 3));
+    graph = createNamedGraph(n);
+    if (graph == NULL) {
+      printf("Error: No se pudo crear el grafo de prueba.\n");
+      return 1;
+    }
+    for (int i = 0; i < n; i++) {
+      for (int j = i + 1; j < n; j++) {
+        if (nextRandom(&seed) % 100 < 35) {
+          addEdge(graph, graph->adjacencyList[i]->name,
+                  graph->adjacencyList[j]->name);
+        }
+      }
+      flows[i] = nextRandom(&seed) % 4 == 0 ? 500 + nextRandom(&seed) % 400
+                                             : 30 + nextRandom(&seed) % 120;
+    }
+    errors += compareGroupings(graph, flows, &originalRatio, &weightedRatio);
+    originalTotal += originalRatio;
+    weightedTotal += weightedRatio;
+    lowered += weightedRatio < originalRatio - 1e-9;
+    raised += weightedRatio > originalRatio + 1e-9;
+    freeGraph(graph);
+  }
+  if (!(weightedTotal < originalTotal)) {
+    printf("Error: En promedio la agrupacion ponderada no bajo Y.\n");
+    errors++;
+  }
+
+  printf("weighted_grouping_test: %d grafos al azar, Y promedio %.3f original "
+         "y %.3f ponderada (%d bajaron, %d subieron), %d errores\n",
+         TEST_INSTANCES, originalTotal / TEST_INSTANCES,
+         weightedTotal / TEST_INSTANCES, lowered, raised, errors);
+  return errors == 0 ? 0 : 1;
+}